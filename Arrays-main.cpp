@@ -0,0 +1,5 @@
+#include "Arrays.h"
+
+int main() {
+	Arrays_init_module();
+}
@@ -0,0 +1,66 @@
+#include "Arrays.h"
+
+static constexpr Oberon_String Arrays_string_0 { "abc", 3 };
+static constexpr Oberon_String Arrays_string_1 { "abd", 3 };
+static constexpr Oberon_String Arrays_string_2 { "ab", 2 };
+static constexpr Oberon_String Arrays_string_3 { "", 0 };
+static constexpr Oberon_String Arrays_string_4 { "a", 1 };
+static constexpr Oberon_String Arrays_string_5 { "x", 1 };
+
+static void init_module_imports() noexcept {
+	Out_init_module();
+}
+
+Oberon_Array<SYSTEM_INTEGER, 3, 4> Arrays_m;
+Oberon_Array<SYSTEM_INTEGER, 4> Arrays_r;
+SYSTEM_INTEGER Arrays_i;
+Oberon_Array<SYSTEM_CHAR, 8> Arrays_s, Arrays_t;
+Oberon_Array<SYSTEM_CHAR, 3> Arrays_u;
+[[maybe_unused]] static auto Arrays_SetRow(Oberon_Open_Array<SYSTEM_INTEGER, 2> Arrays_a, SYSTEM_INTEGER Arrays_k, Oberon_Open_Array<const SYSTEM_INTEGER> Arrays_row) noexcept -> void;
+[[maybe_unused]] static auto Arrays_Order(Oberon_Open_Array<const SYSTEM_CHAR> Arrays_a, Oberon_Open_Array<const SYSTEM_CHAR> Arrays_b) noexcept -> SYSTEM_INTEGER;
+static auto Arrays_SetRow(Oberon_Open_Array<SYSTEM_INTEGER, 2> Arrays_a, SYSTEM_INTEGER Arrays_k, Oberon_Open_Array<const SYSTEM_INTEGER> Arrays_row) noexcept -> void {
+	(Arrays_a).at("Arrays.Mod:14:11", Arrays_k) = Arrays_row;
+}
+static auto Arrays_Order(Oberon_Open_Array<const SYSTEM_CHAR> Arrays_a, Oberon_Open_Array<const SYSTEM_CHAR> Arrays_b) noexcept -> SYSTEM_INTEGER {
+	SYSTEM_INTEGER Arrays_k;
+	if (SYSTEM_compare_strings(Arrays_a, Arrays_b) < 0) {
+		Arrays_k = -1;
+	} else if (SYSTEM_compare_strings(Arrays_a, Arrays_b) == 0) {
+		Arrays_k = 0;
+	} else {
+		Arrays_k = 1;
+	}
+	return Arrays_k;
+}
+void Arrays_init_module() noexcept {
+	static bool already_run { false };
+	if (already_run) { return; }
+	already_run = true;
+	init_module_imports();
+	for (Arrays_i = 0; Arrays_i <= 3; ++Arrays_i) {
+		(Arrays_r)[Arrays_i] = Arrays_i + 7;
+	}
+	(Arrays_m)[0] = Arrays_r;
+	(Arrays_m)[1] = (Arrays_m)[0];
+	(Arrays_r)[0] = 1;
+	Arrays_SetRow(Arrays_m, 2, Arrays_r);
+	Out_Int((Arrays_m)(0, 0), 0);
+	Out_Int((Arrays_m)(1, 3), 3);
+	Out_Int((Arrays_m)(2, 0), 3);
+	Out_Int((Arrays_m)(2, 1), 3);
+	Out_Ln();
+	Arrays_s = Arrays_string_0;
+	Arrays_t = Arrays_string_1;
+	(Arrays_u)[0] = 'a';
+	(Arrays_u)[1] = 'b';
+	(Arrays_u)[2] = 'c';
+	Out_Int(Arrays_Order(Arrays_s, Arrays_t), 0);
+	Out_Int(Arrays_Order(Arrays_t, Arrays_s), 3);
+	Out_Int(Arrays_Order(Arrays_s, Arrays_u), 3);
+	Out_Int(Arrays_Order(Arrays_s, Arrays_string_2), 3);
+	Out_Int(Arrays_Order(Arrays_string_3, Arrays_s), 3);
+	if ((SYSTEM_compare_strings(Arrays_s, Arrays_string_0) == 0) && (SYSTEM_compare_strings(Arrays_s, Arrays_t) != 0) && (SYSTEM_compare_strings(Arrays_t, Arrays_s) > 0) && (SYSTEM_compare_strings(Arrays_s, Arrays_string_0) <= 0) && (SYSTEM_compare_strings(Arrays_s, Arrays_string_4) >= 0) && !((SYSTEM_compare_strings(Arrays_s, Arrays_string_5) == 0))) {
+		Out_Int(1, 3);
+	}
+	Out_Ln();
+}
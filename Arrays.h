@@ -0,0 +1,12 @@
+#pragma once
+
+#include "SYSTEM.h"
+
+#include "Out.h"
+
+extern Oberon_Array<SYSTEM_INTEGER, 3, 4> Arrays_m;
+extern Oberon_Array<SYSTEM_INTEGER, 4> Arrays_r;
+extern SYSTEM_INTEGER Arrays_i;
+extern Oberon_Array<SYSTEM_CHAR, 8> Arrays_s, Arrays_t;
+extern Oberon_Array<SYSTEM_CHAR, 3> Arrays_u;
+void Arrays_init_module() noexcept;
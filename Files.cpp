@@ -1,9 +1,9 @@
 #include "Files.h"
 
-static void init_module_imports() {
+static void init_module_imports() noexcept {
 }
 
-void Files_init_module() {
+void Files_init_module() noexcept {
 	static bool already_run { false };
 	if (already_run) { return; }
 	already_run = true;
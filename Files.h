@@ -4,4 +4,5 @@
 
 struct Files_Handle {
 };
-void Files_init_module();
+inline constexpr SYSTEM_Type_Descriptor Files_Handle_descriptor { &Files_Handle_descriptor };
+void Files_init_module() noexcept;
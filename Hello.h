@@ -4,5 +4,4 @@
 
 #include "Out.h"
 
-auto Hello_isDigit(SYSTEM_CHAR Hello_ch) -> SYSTEM_BOOLEAN;
-void Hello_init_module();
+void Hello_init_module() noexcept;
@@ -1,13 +1,97 @@
 #include "Out.h"
 
-#include <iostream>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 
-void Out_WriteLn() { std::cout << "\n"; }
-void Out_WriteInt(SYSTEM_INTEGER value) { std::cout << value; }
+namespace {
+	char buffer[64 * 1024];
+	std::size_t used { 0 };
+	bool flush_on_line { false };
 
-void Out_init_module() {
+	void write_all(const char* data, std::size_t size) {
+		while (size) {
+			auto written { ::write(STDOUT_FILENO, data, size) };
+			if (written <= 0) { return; }
+			data += written;
+			size -= static_cast<std::size_t>(written);
+		}
+	}
+
+	void put(const char* data, std::size_t size) {
+		if (used + size > sizeof(buffer)) {
+			Out_Flush();
+			if (size > sizeof(buffer)) { write_all(data, size); return; }
+		}
+		std::memcpy(buffer + used, data, size);
+		used += size;
+	}
+
+	void pad(std::size_t length, SYSTEM_INTEGER width) {
+		for (auto i { static_cast<SYSTEM_INTEGER>(length) }; i < width; ++i) {
+			put(" ", 1);
+		}
+	}
+}
+
+void Out_Flush() noexcept {
+	write_all(buffer, used);
+	used = 0;
+}
+
+void Out_Open() noexcept { }
+
+void Out_Char(SYSTEM_CHAR ch) noexcept {
+	if (used == sizeof(buffer)) { Out_Flush(); }
+	buffer[used++] = ch;
+}
+
+// up to the terminating 0X
+void Out_String(Oberon_Open_Array<const SYSTEM_CHAR> str) noexcept {
+	auto end { static_cast<const char*>(std::memchr(str.items, 0, str.lengths[0])) };
+	put(str.items, end ? static_cast<std::size_t>(end - str.items) : str.lengths[0]);
+}
+
+void Out_Int(SYSTEM_INTEGER value, SYSTEM_INTEGER width) noexcept {
+	char digits[16];
+	auto end { std::to_chars(digits, digits + sizeof(digits), value).ptr };
+	pad(static_cast<std::size_t>(end - digits), width);
+	put(digits, static_cast<std::size_t>(end - digits));
+}
+
+void Out_Hex(SYSTEM_INTEGER value) noexcept {
+	char digits[16];
+	auto end {
+		std::to_chars(digits, digits + sizeof(digits), static_cast<unsigned>(value), 16).ptr
+	};
+	for (auto ch { digits }; ch != end; ++ch) {
+		if (*ch >= 'a') { *ch = static_cast<char>(*ch - 'a' + 'A'); }
+	}
+	put(digits, static_cast<std::size_t>(end - digits));
+}
+
+// shortest text that reads back as the same value
+void Out_Real(SYSTEM_REAL value, SYSTEM_INTEGER width) noexcept {
+	char digits[32];
+	auto end { std::to_chars(digits, digits + sizeof(digits), value).ptr };
+	pad(static_cast<std::size_t>(end - digits), width);
+	put(digits, static_cast<std::size_t>(end - digits));
+}
+
+void Out_Ln() noexcept {
+	Out_Char('\n');
+	if (flush_on_line) { Out_Flush(); }
+}
+
+void Out_WriteLn() noexcept { Out_Ln(); }
+void Out_WriteInt(SYSTEM_INTEGER value) noexcept { Out_Int(value, 0); }
+
+void Out_init_module() noexcept {
 	static bool already_run { false };
 	if (already_run) { return; }
 	already_run = true;
+	flush_on_line = ::isatty(STDOUT_FILENO);
+	std::atexit(Out_Flush);
+	SYSTEM_before_trap = Out_Flush;
 }
-
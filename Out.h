@@ -2,6 +2,18 @@
 
 #include "SYSTEM.h"
 
-void Out_init_module();
-void Out_WriteLn();
-void Out_WriteInt(SYSTEM_INTEGER value);
\ No newline at end of file
+// Oakwood Out module. Output is buffered; the buffer is flushed at exit,
+// when it is full and on Ln if standard output is a terminal.
+
+void Out_init_module() noexcept;
+void Out_Open() noexcept;
+void Out_Char(SYSTEM_CHAR ch) noexcept;
+void Out_String(Oberon_Open_Array<const SYSTEM_CHAR> str) noexcept;
+void Out_Int(SYSTEM_INTEGER value, SYSTEM_INTEGER width) noexcept;
+void Out_Hex(SYSTEM_INTEGER value) noexcept;
+void Out_Real(SYSTEM_REAL value, SYSTEM_INTEGER width) noexcept;
+void Out_Ln() noexcept;
+void Out_Flush() noexcept;
+
+void Out_WriteLn() noexcept;
+void Out_WriteInt(SYSTEM_INTEGER value) noexcept;
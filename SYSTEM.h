@@ -2,17 +2,648 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
 using SYSTEM_INTEGER = int;
 using SYSTEM_REAL = double;
 using SYSTEM_CHAR = char;
 using SYSTEM_BOOLEAN = bool;
 
+// Called before a trap stops the program, so a module that buffers
+// output (Out) can write it out first
+inline void (*SYSTEM_before_trap)() noexcept { nullptr };
+
+[[noreturn]] inline void SYSTEM_abort() noexcept {
+	if (SYSTEM_before_trap) { SYSTEM_before_trap(); }
+	std::abort();
+}
+
+// DIV and MOD round towards negative infinity
+constexpr SYSTEM_INTEGER SYSTEM_DIV(SYSTEM_INTEGER x, SYSTEM_INTEGER y) {
+	return x / y - ((x % y != 0 && ((x < 0) != (y < 0))) ? 1 : 0);
+}
+
+constexpr SYSTEM_INTEGER SYSTEM_MOD(SYSTEM_INTEGER x, SYSTEM_INTEGER y) {
+	return x % y + ((x % y != 0 && ((x % y < 0) != (y < 0))) ? y : 0);
+}
+
+// first <= value <= last with one unsigned compare
+constexpr bool SYSTEM_in_range(SYSTEM_INTEGER value, SYSTEM_INTEGER first, SYSTEM_INTEGER last) noexcept {
+	return static_cast<unsigned>(value) - static_cast<unsigned>(first) <=
+		static_cast<unsigned>(last) - static_cast<unsigned>(first);
+}
+
+// value is first + k for a bit k of mask
+constexpr bool SYSTEM_in_mask(SYSTEM_INTEGER value, SYSTEM_INTEGER first, std::uint64_t mask) noexcept {
+	auto offset { static_cast<unsigned>(value) - static_cast<unsigned>(first) };
+	return offset < 64 && ((mask >> offset) & 1) != 0;
+}
+
+// SET is one machine word: element x is bit x, for x in 0 .. 63. The
+// forms with a source position trap on other elements, the others are
+// for unchecked code and elements known to be in range.
+using SYSTEM_SET = std::uint64_t;
+
+constexpr SYSTEM_SET SYSTEM_set_element(SYSTEM_INTEGER x) noexcept {
+	return SYSTEM_SET { 1 } << (static_cast<unsigned>(x) & 63);
+}
+
+// {first .. last}, empty if last < first
+constexpr SYSTEM_SET SYSTEM_set_range(SYSTEM_INTEGER first, SYSTEM_INTEGER last) noexcept {
+	if (last < first) { return 0; }
+	return (~SYSTEM_SET { 0 } >> (63 - (static_cast<unsigned>(last) & 63))) &
+		(~SYSTEM_SET { 0 } << (static_cast<unsigned>(first) & 63));
+}
+
+constexpr bool SYSTEM_IN(SYSTEM_INTEGER x, SYSTEM_SET s) noexcept {
+	return static_cast<unsigned>(x) < 64 && ((s >> x) & 1) != 0;
+}
+
+inline void SYSTEM_INCL(SYSTEM_SET& s, SYSTEM_INTEGER x) noexcept { s |= SYSTEM_set_element(x); }
+inline void SYSTEM_EXCL(SYSTEM_SET& s, SYSTEM_INTEGER x) noexcept { s &= ~SYSTEM_set_element(x); }
+
+// Reports a set element outside 0 .. 63 with the Oberon source position
+// where and stops the program
+[[noreturn]] inline void SYSTEM_trap_set(const char* where, SYSTEM_INTEGER x) noexcept {
+	std::fprintf(stderr, "%s: set element %d out of range 0 .. 63\n", where, x);
+	SYSTEM_abort();
+}
+
+inline SYSTEM_INTEGER SYSTEM_check_element(SYSTEM_INTEGER x, const char* where) noexcept {
+	if (static_cast<unsigned>(x) >= 64) { SYSTEM_trap_set(where, x); }
+	return x;
+}
+
+inline SYSTEM_SET SYSTEM_set_element(SYSTEM_INTEGER x, const char* where) noexcept {
+	return SYSTEM_set_element(SYSTEM_check_element(x, where));
+}
+
+inline SYSTEM_SET SYSTEM_set_range(SYSTEM_INTEGER first, SYSTEM_INTEGER last, const char* where) noexcept {
+	if (last < first) { return 0; }
+	return SYSTEM_set_range(SYSTEM_check_element(first, where), SYSTEM_check_element(last, where));
+}
+
+inline void SYSTEM_INCL(SYSTEM_SET& s, SYSTEM_INTEGER x, const char* where) noexcept {
+	s |= SYSTEM_set_element(x, where);
+}
+
+inline void SYSTEM_EXCL(SYSTEM_SET& s, SYSTEM_INTEGER x, const char* where) noexcept {
+	s &= ~SYSTEM_set_element(x, where);
+}
+
+// string literal with its length known at compile time
 class Oberon_String {
 	private:
 		const char* str_;
+		SYSTEM_INTEGER length_;
 
 	public:
-		explicit Oberon_String(const char* str): str_ { str } { }
-		operator const char*() const { return str_; }
-		operator char() const { return str_[0]; }
+		constexpr Oberon_String(const char* str, SYSTEM_INTEGER length):
+			str_ { str }, length_ { length }
+		{ }
+		constexpr SYSTEM_INTEGER length() const { return length_; }
+		constexpr operator const char*() const { return str_; }
+		constexpr operator char() const { return str_[0]; }
+};
+
+// Reports an index outside 0 .. length - 1 with the Oberon source
+// position where and stops the program
+[[noreturn]] inline void SYSTEM_trap_index(
+	const char* where, SYSTEM_INTEGER index, SYSTEM_INTEGER length
+) noexcept {
+	std::fprintf(stderr, "%s: index %d out of range 0 .. %d\n", where, index, length - 1);
+	SYSTEM_abort();
+}
+
+inline SYSTEM_INTEGER SYSTEM_check_index(
+	SYSTEM_INTEGER index, SYSTEM_INTEGER length, const char* where
+) noexcept {
+	if (static_cast<unsigned>(index) >= static_cast<unsigned>(length)) {
+		SYSTEM_trap_index(where, index, length);
+	}
+	return index;
+}
+
+// Reports a CASE selector that matches no label with the Oberon source
+// position where and stops the program
+[[noreturn]] inline void SYSTEM_trap_case(const char* where) noexcept {
+	std::fprintf(stderr, "%s: no CASE label matches\n", where);
+	SYSTEM_abort();
+}
+
+// Reports a failed type guard with the Oberon source position where
+// and stops the program
+[[noreturn]] inline void SYSTEM_trap_guard(const char* where) noexcept {
+	std::fprintf(stderr, "%s: type guard failed\n", where);
+	SYSTEM_abort();
+}
+
+// Reports a type guard applied to NIL with the Oberon source position
+// where and stops the program
+[[noreturn]] inline void SYSTEM_trap_nil(const char* where) noexcept {
+	std::fprintf(stderr, "%s: type guard on NIL\n", where);
+	SYSTEM_abort();
+}
+
+// Record types extend each other up to this depth
+constexpr int SYSTEM_extension_levels { 8 };
+
+// not constexpr, so a descriptor beyond the limit does not compile
+inline void SYSTEM_extension_too_deep() noexcept { std::abort(); }
+
+// Each record type has a static descriptor. base[k] is the descriptor
+// of its ancestor at extension level k, and base[level] its own, so a
+// type test is one load and compare without RTTI. trace marks the
+// objects a record on the heap points to; it is nullptr for records
+// without pointers.
+struct SYSTEM_Type_Descriptor {
+	using Trace = void (*)(void* object) noexcept;
+
+	int level;
+	const SYSTEM_Type_Descriptor* base[SYSTEM_extension_levels];
+	Trace trace;
+
+	constexpr explicit SYSTEM_Type_Descriptor(const SYSTEM_Type_Descriptor* self, Trace trace = nullptr):
+		level { 0 }, base { self }, trace { trace }
+	{ }
+	constexpr SYSTEM_Type_Descriptor(
+		const SYSTEM_Type_Descriptor& parent, const SYSTEM_Type_Descriptor* self, Trace trace = nullptr
+	):
+		level { parent.level + 1 }, base { }, trace { trace }
+	{
+		if (level >= SYSTEM_extension_levels) { SYSTEM_extension_too_deep(); }
+		for (int i { 0 }; i < level; ++i) { base[i] = parent.base[i]; }
+		base[level] = self;
+	}
+};
+
+// the dynamic type tag is type or one of its extensions; NIL has the
+// tag nullptr, so NIL IS T is false
+constexpr bool SYSTEM_is(const SYSTEM_Type_Descriptor* tag, const SYSTEM_Type_Descriptor& type) noexcept {
+	return tag && tag->base[type.level] == &type;
+}
+
+template<typename T, typename S>
+inline T& SYSTEM_guard(
+	S& value, const SYSTEM_Type_Descriptor* tag, const SYSTEM_Type_Descriptor& type, const char* where
+) noexcept {
+	if (!tag) { SYSTEM_trap_nil(where); }
+	if (!SYSTEM_is(tag, type)) { SYSTEM_trap_guard(where); }
+	return static_cast<T&>(value);
+}
+
+// labels low .. high of the case with the given index
+struct SYSTEM_Case_Label {
+	SYSTEM_INTEGER low, high, index;
 };
+
+// Index of the case with a label holding value, -1 if there is none.
+// Sparse CASE statements switch on it; labels are sorted and disjoint.
+template<SYSTEM_INTEGER N>
+constexpr SYSTEM_INTEGER SYSTEM_find_case(
+	const SYSTEM_Case_Label (&labels)[N], SYSTEM_INTEGER value
+) noexcept {
+	SYSTEM_INTEGER first { 0 }, count { N };
+	while (count > 0) {
+		auto half { count / 2 };
+		if (labels[first + half].high < value) {
+			first += half + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	return first < N && labels[first].low <= value ? labels[first].index : -1;
+}
+
+template<typename T, SYSTEM_INTEGER D>
+struct Oberon_Open_Array;
+
+// Copies the elements of an array with the same lengths, as array
+// assignment does
+template<typename T, typename U>
+inline void SYSTEM_copy_elements(
+	T* items, const SYSTEM_INTEGER* lengths, const U* source, const SYSTEM_INTEGER* source_lengths,
+	SYSTEM_INTEGER rank
+) noexcept {
+	SYSTEM_INTEGER size { 1 };
+	for (SYSTEM_INTEGER k { 0 }; k < rank; ++k) {
+		if (source_lengths[k] != lengths[k]) {
+			std::fprintf(stderr, "array of length %d assigned to array of length %d\n", source_lengths[k], lengths[k]);
+			SYSTEM_abort();
+		}
+		size *= lengths[k];
+	}
+	for (SYSTEM_INTEGER i { 0 }; i < size; ++i) { items[i] = source[i]; }
+}
+
+// Copies a string and its terminating 0X into an ARRAY length OF CHAR
+inline void SYSTEM_copy_string(char* items, SYSTEM_INTEGER length, const Oberon_String& string) noexcept {
+	const char* text { string };
+	if (string.length() >= length) {
+		std::fprintf(stderr, "string of length %d assigned to ARRAY %d OF CHAR\n", string.length(), length);
+		SYSTEM_abort();
+	}
+	for (SYSTEM_INTEGER i { 0 }; i <= string.length(); ++i) { items[i] = text[i]; }
+}
+
+// Element of a row-major block of elements with the given lengths, or a
+// view of a row if there are fewer indices than dimensions. The offset
+// is computed in one expression, the lengths are the strides.
+template<bool checked, SYSTEM_INTEGER rank, typename T, typename... I>
+decltype(auto) SYSTEM_element(
+	T* items, const SYSTEM_INTEGER* lengths, const char* where, I... indices
+) noexcept {
+	static_assert(sizeof...(I) >= 1 && sizeof...(I) <= rank, "wrong number of indices");
+	constexpr SYSTEM_INTEGER count { sizeof...(I) };
+	const SYSTEM_INTEGER values[] { static_cast<SYSTEM_INTEGER>(indices)... };
+	SYSTEM_INTEGER offset { 0 };
+	for (SYSTEM_INTEGER k { 0 }; k < count; ++k) {
+		auto index { values[k] };
+		if constexpr (checked) { index = SYSTEM_check_index(index, lengths[k], where); }
+		offset = offset * lengths[k] + index;
+	}
+	if constexpr (count < rank) {
+		for (SYSTEM_INTEGER k { count }; k < rank; ++k) { offset *= lengths[k]; }
+		return Oberon_Open_Array<T, rank - count> { items + offset, lengths + count };
+	} else {
+		return (items[offset]);
+	}
+}
+
+// ARRAY N0, N1, ... OF T, which is the same as ARRAY N0 OF ARRAY N1 OF
+// ... T: one row-major block of elements, copied on assignment. at()
+// checks the indices, operator[] and operator() do not.
+template<typename T, SYSTEM_INTEGER... N>
+struct Oberon_Array {
+	static constexpr SYSTEM_INTEGER rank { sizeof...(N) };
+	static constexpr SYSTEM_INTEGER lengths[] { N... };
+	static constexpr SYSTEM_INTEGER size { (N * ...) };
+
+	T items[size];
+
+	decltype(auto) operator[](SYSTEM_INTEGER index) noexcept { return (*this)(index); }
+	decltype(auto) operator[](SYSTEM_INTEGER index) const noexcept { return (*this)(index); }
+	template<typename... I>
+	decltype(auto) operator()(I... indices) noexcept {
+		return SYSTEM_element<false, rank>(items, lengths, nullptr, indices...);
+	}
+	template<typename... I>
+	decltype(auto) operator()(I... indices) const noexcept {
+		return SYSTEM_element<false, rank>(items, lengths, nullptr, indices...);
+	}
+	template<typename... I>
+	decltype(auto) at(const char* where, I... indices) noexcept {
+		return SYSTEM_element<true, rank>(items, lengths, where, indices...);
+	}
+	template<typename... I>
+	decltype(auto) at(const char* where, I... indices) const noexcept {
+		return SYSTEM_element<true, rank>(items, lengths, where, indices...);
+	}
+
+	// a row of another array
+	template<typename U>
+	Oberon_Array& operator=(const Oberon_Open_Array<U, rank>& row) noexcept {
+		SYSTEM_copy_elements(items, lengths, row.items, row.lengths, rank);
+		return *this;
+	}
+
+	// a string assigned to an ARRAY OF CHAR is terminated by 0X
+	template<
+		typename S,
+		typename = std::enable_if_t<std::is_same_v<S, Oberon_String> && std::is_same_v<T, char> && rank == 1>
+	>
+	Oberon_Array& operator=(const S& string) noexcept {
+		SYSTEM_copy_string(items, size, string);
+		return *this;
+	}
+};
+
+// ARRAY OF ... ARRAY OF T parameter with D open dimensions: a view of the
+// elements of the actual array and its lengths. T is const for value
+// parameters, which can also be string literals. Rows of arrays are
+// views, too; assigning to a view copies elements, like assigning to
+// the array it shows.
+template<typename T, SYSTEM_INTEGER D = 1>
+struct Oberon_Open_Array {
+	static constexpr SYSTEM_INTEGER rank { D };
+
+	T* items;
+	SYSTEM_INTEGER lengths[D];
+
+	Oberon_Open_Array(T* items, const SYSTEM_INTEGER* lengths) noexcept: items { items } {
+		for (SYSTEM_INTEGER k { 0 }; k < D; ++k) { this->lengths[k] = lengths[k]; }
+	}
+	template<typename U, SYSTEM_INTEGER... N, typename = std::enable_if_t<sizeof...(N) == D>>
+	Oberon_Open_Array(Oberon_Array<U, N...>& array) noexcept:
+		items { array.items }, lengths { N... }
+	{ }
+	template<typename U, SYSTEM_INTEGER... N, typename = std::enable_if_t<sizeof...(N) == D>>
+	Oberon_Open_Array(const Oberon_Array<U, N...>& array) noexcept:
+		items { array.items }, lengths { N... }
+	{ }
+	template<typename U>
+	Oberon_Open_Array(const Oberon_Open_Array<U, D>& array) noexcept:
+		Oberon_Open_Array { array.items, array.lengths }
+	{ }
+	Oberon_Open_Array(const Oberon_String& string) noexcept:
+		items { string }, lengths { string.length() + 1 }
+	{ }
+	Oberon_Open_Array(const Oberon_Open_Array& array) noexcept = default;
+
+	const Oberon_Open_Array& operator=(const Oberon_Open_Array& array) const noexcept {
+		SYSTEM_copy_elements(items, lengths, array.items, array.lengths, D);
+		return *this;
+	}
+	template<typename U>
+	const Oberon_Open_Array& operator=(const Oberon_Open_Array<U, D>& array) const noexcept {
+		SYSTEM_copy_elements(items, lengths, array.items, array.lengths, D);
+		return *this;
+	}
+	template<typename U, SYSTEM_INTEGER... N, typename = std::enable_if_t<sizeof...(N) == D>>
+	const Oberon_Open_Array& operator=(const Oberon_Array<U, N...>& array) const noexcept {
+		SYSTEM_copy_elements(items, lengths, array.items, array.lengths, D);
+		return *this;
+	}
+	template<
+		typename S,
+		typename = std::enable_if_t<std::is_same_v<S, Oberon_String> && std::is_same_v<T, char> && D == 1>
+	>
+	const Oberon_Open_Array& operator=(const S& string) const noexcept {
+		SYSTEM_copy_string(items, lengths[0], string);
+		return *this;
+	}
+
+	decltype(auto) operator[](SYSTEM_INTEGER index) const noexcept { return (*this)(index); }
+	template<typename... I>
+	decltype(auto) operator()(I... indices) const noexcept {
+		return SYSTEM_element<false, D>(items, lengths, nullptr, indices...);
+	}
+	template<typename... I>
+	decltype(auto) at(const char* where, I... indices) const noexcept {
+		return SYSTEM_element<true, D>(items, lengths, where, indices...);
+	}
+};
+
+// Compares the strings in two character arrays, each ending at its 0X
+// or at the end of the array; less than, equal to or greater than 0
+// like strcmp
+inline SYSTEM_INTEGER SYSTEM_compare_strings(
+	Oberon_Open_Array<const char> a, Oberon_Open_Array<const char> b
+) noexcept {
+	for (SYSTEM_INTEGER i { 0 };; ++i) {
+		auto x { i < a.lengths[0] ? static_cast<unsigned char>(a.items[i]) : 0 };
+		auto y { i < b.lengths[0] ? static_cast<unsigned char>(b.items[i]) : 0 };
+		if (x != y || x == 0) { return x - y; }
+	}
+}
+
+// Heap for NEW. Every object follows a block header with its type tag.
+// Blocks up to SYSTEM_small_block bytes come in size classes 16 bytes
+// apart; each thread takes them from its own free list of the class or
+// from a bump pointer into a page of the class. Larger blocks are
+// allocated one by one.
+struct SYSTEM_Block {
+	const SYSTEM_Type_Descriptor* tag; // nullptr while the block is free
+	std::uint32_t size;
+	std::uint32_t marked;
+};
+
+constexpr std::size_t SYSTEM_granule { 16 };
+constexpr std::size_t SYSTEM_size_classes { 32 };
+constexpr std::size_t SYSTEM_small_block { SYSTEM_granule * SYSTEM_size_classes };
+constexpr std::size_t SYSTEM_page_size { 64 * 1024 };
+static_assert(sizeof(SYSTEM_Block) == SYSTEM_granule, "objects have to stay aligned");
+
+struct SYSTEM_Heap_Stats {
+	std::uint64_t allocated;        // objects allocated by NEW
+	std::uint64_t allocated_bytes;  // their blocks, headers included
+	std::uint64_t freed;            // objects freed by the collector
+	std::uint64_t freed_bytes;
+	std::uint64_t pages;            // pages and large blocks taken from the system
+	std::uint64_t collections;
+};
+
+struct SYSTEM_Thread_Heap {
+	SYSTEM_Block* free[SYSTEM_size_classes] { };
+	char* next[SYSTEM_size_classes] { };
+	char* end[SYSTEM_size_classes] { };
+	// written by the owning thread only, read by SYSTEM_heap_stats
+	std::atomic<std::uint64_t> allocated { 0 };
+	std::atomic<std::uint64_t> allocated_bytes { 0 };
+};
+
+struct SYSTEM_Page {
+	char* begin;
+	std::size_t block_size;
+};
+
+// shared by all threads, guarded by mutex; never destroyed, so threads
+// and static destructors can allocate until the end
+struct SYSTEM_Heap {
+	std::mutex mutex;
+	std::vector<SYSTEM_Page> pages;
+	std::vector<SYSTEM_Block*> large;
+	std::vector<SYSTEM_Thread_Heap*> threads;
+	std::vector<void (*)() noexcept> roots;
+	std::vector<void*> marking;
+	SYSTEM_Heap_Stats stats { };
+};
+
+inline SYSTEM_Heap& SYSTEM_heap() noexcept {
+	static auto* heap { new SYSTEM_Heap { } };
+	return *heap;
+}
+
+inline SYSTEM_Thread_Heap& SYSTEM_thread_heap() noexcept {
+	thread_local SYSTEM_Thread_Heap* local { [] {
+		auto& heap { SYSTEM_heap() };
+		auto* result { new SYSTEM_Thread_Heap { } };
+		std::lock_guard<std::mutex> lock { heap.mutex };
+		heap.threads.push_back(result);
+		return result;
+	}() };
+	return *local;
+}
+
+[[noreturn]] inline void SYSTEM_out_of_memory(std::size_t size) noexcept {
+	std::fprintf(stderr, "NEW: out of memory for %zu bytes\n", size);
+	SYSTEM_abort();
+}
+
+// cleared memory, so unused blocks read as free
+inline char* SYSTEM_system_block(std::size_t size, std::size_t block_size) noexcept {
+	auto& heap { SYSTEM_heap() };
+	auto* memory { static_cast<char*>(std::calloc(1, size)) };
+	if (!memory) { SYSTEM_out_of_memory(size); }
+	std::lock_guard<std::mutex> lock { heap.mutex };
+	if (block_size) {
+		heap.pages.push_back({ memory, block_size });
+	} else {
+		heap.large.push_back(reinterpret_cast<SYSTEM_Block*>(memory));
+	}
+	++heap.stats.pages;
+	return memory;
+}
+
+inline void* SYSTEM_allocate(std::size_t size, const SYSTEM_Type_Descriptor& type) noexcept {
+	auto block_size { (size + sizeof(SYSTEM_Block) + SYSTEM_granule - 1) & ~(SYSTEM_granule - 1) };
+	auto& local { SYSTEM_thread_heap() };
+	SYSTEM_Block* block;
+	if (block_size <= SYSTEM_small_block) {
+		auto k { block_size / SYSTEM_granule - 1 };
+		if (local.free[k]) {
+			block = local.free[k];
+			local.free[k] = *reinterpret_cast<SYSTEM_Block**>(block + 1);
+		} else {
+			if (static_cast<std::size_t>(local.end[k] - local.next[k]) < block_size) {
+				local.next[k] = SYSTEM_system_block(SYSTEM_page_size, block_size);
+				local.end[k] = local.next[k] + SYSTEM_page_size;
+			}
+			block = reinterpret_cast<SYSTEM_Block*>(local.next[k]);
+			local.next[k] += block_size;
+		}
+	} else {
+		block = reinterpret_cast<SYSTEM_Block*>(SYSTEM_system_block(block_size, 0));
+	}
+	block->tag = &type;
+	block->size = static_cast<std::uint32_t>(block_size);
+	block->marked = 0;
+	local.allocated.store(local.allocated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	local.allocated_bytes.store(
+		local.allocated_bytes.load(std::memory_order_relaxed) + block_size, std::memory_order_relaxed
+	);
+	return block + 1;
+}
+
+// NEW(p) for a pointer to records described by type
+template<typename T>
+inline void SYSTEM_NEW(T*& pointer, const SYSTEM_Type_Descriptor& type) noexcept {
+	pointer = new (SYSTEM_allocate(sizeof(T), type)) T { };
+}
+
+// nullptr for NIL
+inline const SYSTEM_Type_Descriptor* SYSTEM_tag(const void* object) noexcept {
+	if (!object) { return nullptr; }
+	return (static_cast<const SYSTEM_Block*>(object) - 1)->tag;
+}
+
+template<typename T, typename S>
+inline T* SYSTEM_guard(S* pointer, const SYSTEM_Type_Descriptor& type, const char* where) noexcept {
+	if (!pointer) { SYSTEM_trap_nil(where); }
+	if (!SYSTEM_is(SYSTEM_tag(pointer), type)) { SYSTEM_trap_guard(where); }
+	return static_cast<T*>(pointer);
+}
+
+// Tracing for the collector: records with pointers have a member
+// SYSTEM_trace that traces their fields. NIL marks nothing, so only
+// heap blocks reach the marking stack.
+inline void SYSTEM_mark(void* object) noexcept {
+	if (!object) { return; }
+	auto block { static_cast<SYSTEM_Block*>(object) - 1 };
+	if (block->marked) { return; }
+	block->marked = 1;
+	if (block->tag->trace) { SYSTEM_heap().marking.push_back(object); }
+}
+
+template<typename T>
+inline void SYSTEM_trace(T* pointer) noexcept {
+	SYSTEM_mark(pointer);
+}
+
+template<typename T>
+inline auto SYSTEM_trace(T& record) noexcept -> decltype(record.SYSTEM_trace()) {
+	record.SYSTEM_trace();
+}
+
+template<typename T, SYSTEM_INTEGER... N>
+inline void SYSTEM_trace(Oberon_Array<T, N...>& array) noexcept {
+	for (auto& item : array.items) { SYSTEM_trace(item); }
+}
+
+template<typename T>
+void SYSTEM_trace_object(void* object) noexcept {
+	SYSTEM_trace(*static_cast<T*>(object));
+}
+
+// trace_globals traces the global variables of a module that hold
+// pointers; returns true, so it can initialize a static
+inline bool SYSTEM_add_roots(void (*trace_globals)() noexcept) noexcept {
+	auto& heap { SYSTEM_heap() };
+	std::lock_guard<std::mutex> lock { heap.mutex };
+	heap.roots.push_back(trace_globals);
+	return true;
+}
+
+// Mark and sweep collection of the objects that the global variables of
+// the modules do not reach. Local variables are not roots, as in the
+// Oberon System: collect only where no active procedure holds the only
+// pointer to an object, and while no other thread allocates. Freed blocks
+// go to the free lists of the calling thread.
+inline void SYSTEM_COLLECT() noexcept {
+	auto& local { SYSTEM_thread_heap() };
+	auto& heap { SYSTEM_heap() };
+	std::lock_guard<std::mutex> lock { heap.mutex };
+	for (auto trace_globals : heap.roots) { trace_globals(); }
+	while (!heap.marking.empty()) {
+		auto object { heap.marking.back() };
+		heap.marking.pop_back();
+		SYSTEM_tag(object)->trace(object);
+	}
+	auto sweep = [&](SYSTEM_Block* block) {
+		if (!block->tag) { return false; }
+		if (block->marked) {
+			block->marked = 0;
+			return false;
+		}
+		++heap.stats.freed;
+		heap.stats.freed_bytes += block->size;
+		block->tag = nullptr;
+		return true;
+	};
+	for (const auto& page : heap.pages) {
+		auto k { page.block_size / SYSTEM_granule - 1 };
+		for (auto p { page.begin }; p + page.block_size <= page.begin + SYSTEM_page_size; p += page.block_size) {
+			auto block { reinterpret_cast<SYSTEM_Block*>(p) };
+			if (!sweep(block)) { continue; }
+			*reinterpret_cast<SYSTEM_Block**>(block + 1) = local.free[k];
+			local.free[k] = block;
+		}
+	}
+	std::size_t kept { 0 };
+	for (auto* block : heap.large) {
+		if (sweep(block)) {
+			std::free(block);
+		} else {
+			heap.large[kept++] = block;
+		}
+	}
+	heap.large.resize(kept);
+	++heap.stats.collections;
+}
+
+inline SYSTEM_Heap_Stats SYSTEM_heap_stats() noexcept {
+	auto& heap { SYSTEM_heap() };
+	std::lock_guard<std::mutex> lock { heap.mutex };
+	auto result { heap.stats };
+	for (const auto* local : heap.threads) {
+		result.allocated += local->allocated.load(std::memory_order_relaxed);
+		result.allocated_bytes += local->allocated_bytes.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+// bytes of the objects in use, for SYSTEM.ALLOCATED()
+inline SYSTEM_INTEGER SYSTEM_ALLOCATED() noexcept {
+	auto stats { SYSTEM_heap_stats() };
+	auto bytes { stats.allocated_bytes - stats.freed_bytes };
+	constexpr std::uint64_t most { static_cast<std::uint64_t>(~0u >> 1) };
+	return static_cast<SYSTEM_INTEGER>(bytes < most ? bytes : most);
+}
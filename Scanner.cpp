@@ -1,23 +1,26 @@
 #include "Scanner.h"
 
-static void init_module_imports() {
+static void init_module_imports() noexcept {
 	Token_init_module();
 }
 
 SYSTEM_INTEGER Scanner_token;
-auto Scanner_isDigit(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN {
-	return Scanner_ch >= Oberon_String { "0" } && Scanner_ch <= Oberon_String { "9" };
+[[maybe_unused]] static auto Scanner_isDigit(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN;
+[[maybe_unused]] static auto Scanner_isLetter(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN;
+[[maybe_unused]] static auto Scanner_isWhitespace(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN;
+static auto Scanner_isDigit(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN {
+	return SYSTEM_in_range(static_cast<unsigned char>(Scanner_ch), '0', '9');
 }
-auto Scanner_isLetter(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN {
-	return (Scanner_ch >= Oberon_String { "a" } && Scanner_ch <= Oberon_String { "z" }) || (Scanner_ch >= Oberon_String { "A" } && Scanner_ch <= Oberon_String { "Z" });
+static auto Scanner_isLetter(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN {
+	return SYSTEM_in_mask(static_cast<unsigned char>(Scanner_ch), 'A', 0x3FFFFFF03FFFFFFull);
 }
-auto Scanner_isWhitespace(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN {
-	return Scanner_ch == Oberon_String { " " } || Scanner_ch == '\x09' || Scanner_ch == '\x0C' || Scanner_ch == '\x0B' || Scanner_ch == '\x0A' || Scanner_ch == '\x0D';
+static auto Scanner_isWhitespace(SYSTEM_CHAR Scanner_ch) noexcept -> SYSTEM_BOOLEAN {
+	return SYSTEM_in_mask(static_cast<unsigned char>(Scanner_ch), '\x09', 0x80001Full);
 }
-void Scanner_init_module() {
+void Scanner_init_module() noexcept {
 	static bool already_run { false };
 	if (already_run) { return; }
 	already_run = true;
 	init_module_imports();
-	Scanner_token = Token_unknown;
+	Scanner_token = 0;
 }
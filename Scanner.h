@@ -5,7 +5,4 @@
 #include "Token.h"
 
 extern SYSTEM_INTEGER Scanner_token;
-auto Scanner_isDigit(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN;
-auto Scanner_isLetter(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN;
-auto Scanner_isWhitespace(SYSTEM_CHAR Scanner_ch) -> SYSTEM_BOOLEAN;
-void Scanner_init_module();
+void Scanner_init_module() noexcept;
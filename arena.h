@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for the syntax tree of one module. Everything allocated
+// here lives until the arena is destroyed; no destructors are run.
+
+class Arena {
+	private:
+		static constexpr std::size_t block_size { 64 * 1024 };
+
+		std::vector<std::unique_ptr<char[]>> blocks_;
+		char* pos_ { nullptr };
+		char* end_ { nullptr };
+
+		void* allocate_slow(std::size_t size, std::size_t align) {
+			auto capacity { size + align > block_size ? size + align : block_size };
+			blocks_.emplace_back(new char[capacity]);
+			pos_ = blocks_.back().get();
+			end_ = pos_ + capacity;
+			return allocate(size, align);
+		}
+
+	public:
+		Arena() = default;
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void* allocate(std::size_t size, std::size_t align) {
+			auto address { reinterpret_cast<std::uintptr_t>(pos_) };
+			auto aligned { (address + align - 1) & ~(align - 1) };
+			if (!pos_ || aligned + size > reinterpret_cast<std::uintptr_t>(end_)) {
+				return allocate_slow(size, align);
+			}
+			pos_ = reinterpret_cast<char*>(aligned + size);
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		template<typename T, typename... Args>
+		T* make(Args&&... args) {
+			static_assert(std::is_trivially_destructible_v<T>);
+			return new (allocate(sizeof(T), alignof(T))) T { std::forward<Args>(args)... };
+		}
+
+		template<typename T>
+		T* copy(const T* items, std::size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (!count) { return nullptr; }
+			auto result { static_cast<T*>(allocate(sizeof(T) * count, alignof(T))) };
+			std::memcpy(result, items, sizeof(T) * count);
+			return result;
+		}
+
+		std::string_view copy(std::string_view text) {
+			return { copy(text.data(), text.size()), text.size() };
+		}
+};
+
+// Interned identifier: equal names share their characters, so comparing
+// two names of the same Interner is a pointer compare.
+class Name {
+	private:
+		std::string_view text_;
+
+		explicit Name(std::string_view text): text_ { text } { }
+		friend class Interner;
+
+	public:
+		Name() = default;
+
+		std::string_view text() const { return text_; }
+		bool empty() const { return text_.empty(); }
+		bool operator==(const Name& other) const {
+			return text_.data() == other.text_.data() && text_.size() == other.text_.size();
+		}
+		bool operator!=(const Name& other) const { return !(*this == other); }
+};
+
+// Open addressing set of names. The first spelling of a name is kept as
+// its canonical text, so it has to outlive the interner (the mapped
+// source or a string literal).
+class Interner {
+	private:
+		std::vector<std::string_view> slots_ = std::vector<std::string_view>(256);
+		std::size_t used_ { 0 };
+
+		static std::size_t hash(std::string_view text) {
+			std::size_t value { 2166136261u };
+			for (unsigned char ch : text) { value = (value ^ ch) * 16777619u; }
+			return value;
+		}
+
+		void grow() {
+			std::vector<std::string_view> old(slots_.size() * 2);
+			old.swap(slots_);
+			for (const auto& text : old) {
+				if (text.data()) { slots_[find(text)] = text; }
+			}
+		}
+
+		std::size_t find(std::string_view text) const {
+			auto mask { slots_.size() - 1 };
+			auto slot { hash(text) & mask };
+			while (slots_[slot].data() && slots_[slot] != text) {
+				slot = (slot + 1) & mask;
+			}
+			return slot;
+		}
+
+	public:
+		Name intern(std::string_view text) {
+			auto slot { find(text) };
+			if (!slots_[slot].data()) {
+				if (2 * (used_ + 1) > slots_.size()) {
+					grow();
+					slot = find(text);
+				}
+				slots_[slot] = text;
+				++used_;
+			}
+			return Name { slots_[slot] };
+		}
+};
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "SYSTEM.h"
+#include "arena.h"
+
+// Syntax tree of one module. Nodes are allocated in the Arena of their
+// Module and only hold trivially destructible members.
+
+using Token = SYSTEM_INTEGER;
+using Position = std::uint32_t;
+
+template<typename T>
+struct Span {
+	T* items { nullptr };
+	std::uint32_t count { 0 };
+
+	T* begin() const { return items; }
+	T* end() const { return items + count; }
+	bool empty() const { return count == 0; }
+	std::uint32_t size() const { return count; }
+	T& operator[](std::uint32_t index) const { return items[index]; }
+};
+
+template<typename T>
+Span<T> make_span(Arena& arena, const std::vector<T>& items) {
+	return { arena.copy(items.data(), items.size()), static_cast<std::uint32_t>(items.size()) };
+}
+
+// module is empty for names that are not qualified by an import
+struct QualIdent {
+	Name module;
+	Name name;
+};
+
+struct IdentDef {
+	Name name;
+	bool exported;
+	Position pos;
+};
+
+enum class ExprKind : std::uint8_t {
+	integer, real, string, character, nil, boolean,
+	ident, field, index, deref, call, unary, binary, paren, constant, set
+};
+
+// Result of evaluating a constant expression; BOOLEAN and CHAR values and
+// the bits of SET values are stored in integer.
+enum class ValueKind : std::uint8_t {
+	integer, real, boolean, character, string, set
+};
+
+struct Value {
+	ValueKind kind { ValueKind::integer };
+	std::int64_t integer { 0 };
+	double real { 0 };
+	std::string_view string { };
+};
+
+struct Expr {
+	ExprKind kind;
+	Position pos;
+};
+
+// integer, real, string and character keep their source text
+struct Literal: Expr {
+	std::string_view text;
+};
+
+struct BooleanLiteral: Expr {
+	bool value;
+};
+
+struct Ident: Expr {
+	QualIdent ident;
+};
+
+struct Field: Expr {
+	Expr* base;
+	Name field;
+};
+
+struct Index: Expr {
+	Expr* base;
+	Span<Expr*> indices;
+};
+
+struct Deref: Expr {
+	Expr* base;
+};
+
+struct Call: Expr {
+	Expr* procedure;
+	Span<Expr*> arguments;
+};
+
+struct Unary: Expr {
+	Token op;
+	Expr* operand;
+};
+
+struct Binary: Expr {
+	Token op;
+	Expr* left;
+	Expr* right;
+};
+
+struct Paren: Expr {
+	Expr* inner;
+};
+
+// high is nullptr for a single element
+struct SetElement {
+	Expr* low;
+	Expr* high;
+};
+
+struct SetExpr: Expr {
+	Span<SetElement> elements { };
+};
+
+// replaces a folded constant expression
+struct Constant: Expr {
+	Value value;
+};
+
+enum class TypeKind : std::uint8_t {
+	named, array, open_array, record, pointer, procedure
+};
+
+struct Type {
+	TypeKind kind;
+	Position pos;
+};
+
+struct NamedType: Type {
+	QualIdent ident;
+};
+
+struct ArrayType: Type {
+	Span<Expr*> lengths;
+	Type* element;
+};
+
+struct OpenArrayType: Type {
+	Type* element;
+};
+
+struct FieldList {
+	Span<IdentDef> names;
+	Type* type;
+};
+
+struct RecordType: Type {
+	Type* base { nullptr };
+	Span<FieldList> fields { };
+};
+
+struct PointerType: Type {
+	Type* target;
+};
+
+struct ParameterSection {
+	bool reference;
+	Span<IdentDef> names;
+	Type* type;
+};
+
+struct Signature {
+	Span<ParameterSection> sections;
+	Type* result { nullptr };
+};
+
+struct ProcedureType: Type {
+	Signature* signature;
+};
+
+enum class StmtKind : std::uint8_t {
+	assignment, call, if_then, case_of, while_do, repeat_until, for_do
+};
+
+struct Stmt {
+	StmtKind kind;
+	Position pos;
+};
+
+using Statements = Span<Stmt*>;
+
+struct Assignment: Stmt {
+	Expr* target;
+	Expr* value;
+};
+
+// a designator without parameters is a call, too
+struct CallStmt: Stmt {
+	Expr* call;
+};
+
+struct Branch {
+	Expr* condition;
+	Statements body;
+};
+
+struct IfStmt: Stmt {
+	Span<Branch> branches { };
+	Statements otherwise { };
+	bool has_else { false };
+};
+
+// high is nullptr for a label that is a single value
+struct CaseLabel {
+	Expr* low;
+	Expr* high;
+};
+
+struct Case {
+	Span<CaseLabel> labels;
+	Statements body;
+};
+
+// without ELSE a selector that matches no label traps. In a type CASE
+// the labels are types that the selector variable is tested for; it is
+// told apart by fold_module.
+struct CaseStmt: Stmt {
+	Expr* selector { nullptr };
+	Span<Case> cases { };
+	Statements otherwise { };
+	bool has_else { false };
+	bool type_test { false };
+};
+
+// the ELSIF branches of an Oberon-07 WHILE are tried in each iteration
+struct WhileStmt: Stmt {
+	Span<Branch> branches { };
+};
+
+struct RepeatStmt: Stmt {
+	Statements body { };
+	Expr* condition { nullptr };
+};
+
+// step is a constant, folding sets it to 1 if it is left out
+struct ForStmt: Stmt {
+	Name control { };
+	Expr* begin { nullptr };
+	Expr* end { nullptr };
+	Expr* step { nullptr };
+	Statements body { };
+};
+
+struct ConstDecl {
+	IdentDef ident;
+	Expr* value;
+};
+
+struct TypeDecl {
+	IdentDef ident;
+	Type* type;
+};
+
+struct VarDecl {
+	Span<IdentDef> names;
+	Type* type;
+};
+
+struct ProcDecl;
+
+struct Declarations {
+	Span<ConstDecl*> consts;
+	Span<TypeDecl*> types;
+	Span<VarDecl*> vars;
+	Span<ProcDecl*> procedures;
+};
+
+struct ProcDecl {
+	IdentDef ident;
+	Signature* signature { nullptr };
+	Declarations declarations { };
+	Statements body { };
+	Expr* result { nullptr };
+};
+
+struct Import {
+	Name alias;
+	Name module;
+};
+
+struct Module {
+	Arena arena;
+	Interner names;
+	// positions are offsets into the source text
+	std::string_view source;
+
+	Name name;
+	Span<Import> imports;
+	Declarations declarations;
+	Statements body;
+};
@@ -0,0 +1,113 @@
+#include "cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+	constexpr std::string_view cache_magic { "o2c++ cache 2\n" };
+
+	bool read_file(const std::string& path, std::string& content) {
+		std::ifstream in { path, std::ios::binary };
+		if (!in) { return false; }
+		std::ostringstream buffer;
+		buffer << in.rdbuf();
+		content = buffer.str();
+		return true;
+	}
+
+	std::string temp_name(const std::string& path) {
+		std::ostringstream name;
+		name << path << ".tmp." << ::getpid() << "." << std::this_thread::get_id();
+		return name.str();
+	}
+
+	void replace_file(const std::string& path, std::string_view content) {
+		auto temp { temp_name(path) };
+		{
+			std::ofstream out { temp, std::ios::binary | std::ios::trunc };
+			out.write(content.data(), content.size());
+			if (!out.flush()) {
+				std::error_code ignored;
+				std::filesystem::remove(temp, ignored);
+				throw std::runtime_error { "can't write " + path };
+			}
+		}
+		std::error_code failed;
+		std::filesystem::rename(temp, path, failed);
+		if (failed) {
+			std::filesystem::remove(temp, failed);
+			throw std::runtime_error { "can't write " + path };
+		}
+	}
+}
+
+Hash& Hash::add(std::string_view bytes) {
+	// FNV-1a; the length separates consecutive parts
+	auto length { bytes.size() };
+	for (int i { 0 }; i < 8; ++i, length >>= 8) {
+		value_ = (value_ ^ (length & 0xff)) * 1099511628211ull;
+	}
+	for (unsigned char ch : bytes) {
+		value_ = (value_ ^ ch) * 1099511628211ull;
+	}
+	return *this;
+}
+
+std::string Hash::hex() const {
+	static constexpr char digits[] { "0123456789abcdef" };
+	std::string result(16, '0');
+	auto value { value_ };
+	for (int i { 15 }; i >= 0; --i, value >>= 4) { result[i] = digits[value & 0xf]; }
+	return result;
+}
+
+bool Cache::load(const Hash& key, std::string& h, std::string& cxx, std::string& smb) const {
+	std::string entry;
+	if (!read_file(dir_ + "/" + key.hex(), entry)) { return false; }
+	if (entry.compare(0, cache_magic.size(), cache_magic)) { return false; }
+	std::istringstream sizes { entry.substr(cache_magic.size(), 64) };
+	std::size_t h_size { 0 }, cxx_size { 0 }, smb_size { 0 };
+	if (!(sizes >> h_size >> cxx_size >> smb_size)) { return false; }
+	auto start { entry.find('\n', cache_magic.size()) };
+	if (start == std::string::npos ||
+		entry.size() - start - 1 != h_size + cxx_size + smb_size
+	) {
+		return false;
+	}
+	h = entry.substr(start + 1, h_size);
+	cxx = entry.substr(start + 1 + h_size, cxx_size);
+	smb = entry.substr(start + 1 + h_size + cxx_size);
+	return true;
+}
+
+void Cache::store(
+	const Hash& key, std::string_view h, std::string_view cxx, std::string_view smb
+) const {
+	std::error_code failed;
+	std::filesystem::create_directories(dir_, failed);
+	if (failed) { return; }
+	std::string entry { cache_magic };
+	entry += std::to_string(h.size()) + " " + std::to_string(cxx.size()) + " " +
+		std::to_string(smb.size()) + "\n";
+	entry += h;
+	entry += cxx;
+	entry += smb;
+	try {
+		replace_file(dir_ + "/" + key.hex(), entry);
+	}
+	catch (const std::runtime_error&) {
+		// the cache is an optimization only
+	}
+}
+
+bool write_if_changed(const std::string& path, std::string_view content) {
+	std::string existing;
+	if (read_file(path, existing) && existing == content) { return false; }
+	replace_file(path, content);
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Persistent translation cache: maps a hash over the module source, the
+// translator version and the options to the generated header, body and
+// symbol file.
+
+class Hash {
+	private:
+		std::uint64_t value_ { 14695981039346656037ull };
+
+	public:
+		Hash& add(std::string_view bytes);
+		std::uint64_t value() const { return value_; }
+		std::string hex() const;
+};
+
+class Cache {
+	private:
+		std::string dir_;
+
+	public:
+		explicit Cache(std::string dir): dir_ { std::move(dir) } { }
+
+		bool load(const Hash& key, std::string& h, std::string& cxx, std::string& smb) const;
+		void store(
+			const Hash& key, std::string_view h, std::string_view cxx, std::string_view smb
+		) const;
+};
+
+// Replace path by content via a temporary file, but only if the bytes
+// differ. Returns false if the file was already up to date.
+bool write_if_changed(const std::string& path, std::string_view content);
@@ -0,0 +1,123 @@
+#include "chars.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define CHARS_X86 1
+	#include <immintrin.h>
+#endif
+
+namespace {
+	using Skipper = const char* (*)(const char* pos, const char* end);
+
+	const char* scalar_whitespace(const char* pos, const char* end) {
+		while (pos != end && is_whitespace(*pos)) { ++pos; }
+		return pos;
+	}
+
+	const char* scalar_ident(const char* pos, const char* end) {
+		while (pos != end && is_ident_char(*pos)) { ++pos; }
+		return pos;
+	}
+
+#ifdef CHARS_X86
+	// Unsigned range tests via signed compares: shifting lo to -128 turns
+	// lo <= ch <= hi into ch + (-128 - lo) < -128 + (hi - lo + 1).
+
+	__attribute__((target("sse2")))
+	__m128i in_range_16(__m128i chars, char lo, char hi) {
+		auto shifted { _mm_add_epi8(chars, _mm_set1_epi8(static_cast<char>(-128 - lo))) };
+		return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + (hi - lo + 1))));
+	}
+
+	__attribute__((target("sse2")))
+	const char* sse2_whitespace(const char* pos, const char* end) {
+		while (end - pos >= 16) {
+			auto chars { _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)) };
+			auto hit { _mm_or_si128(
+				_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+				in_range_16(chars, '\t', '\r')
+			) };
+			unsigned miss { ~static_cast<unsigned>(_mm_movemask_epi8(hit)) & 0xffffu };
+			if (miss) { return pos + __builtin_ctz(miss); }
+			pos += 16;
+		}
+		return scalar_whitespace(pos, end);
+	}
+
+	__attribute__((target("sse2")))
+	const char* sse2_ident(const char* pos, const char* end) {
+		while (end - pos >= 16) {
+			auto chars { _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)) };
+			auto hit { _mm_or_si128(
+				_mm_or_si128(in_range_16(chars, 'a', 'z'), in_range_16(chars, 'A', 'Z')),
+				in_range_16(chars, '0', '9')
+			) };
+			unsigned miss { ~static_cast<unsigned>(_mm_movemask_epi8(hit)) & 0xffffu };
+			if (miss) { return pos + __builtin_ctz(miss); }
+			pos += 16;
+		}
+		return scalar_ident(pos, end);
+	}
+
+	__attribute__((target("avx2")))
+	__m256i in_range_32(__m256i chars, char lo, char hi) {
+		auto shifted { _mm256_add_epi8(chars, _mm256_set1_epi8(static_cast<char>(-128 - lo))) };
+		return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + (hi - lo + 1))), shifted);
+	}
+
+	__attribute__((target("avx2")))
+	const char* avx2_whitespace(const char* pos, const char* end) {
+		while (end - pos >= 32) {
+			auto chars { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos)) };
+			auto hit { _mm256_or_si256(
+				_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+				in_range_32(chars, '\t', '\r')
+			) };
+			unsigned miss { ~static_cast<unsigned>(_mm256_movemask_epi8(hit)) };
+			if (miss) { return pos + __builtin_ctz(miss); }
+			pos += 32;
+		}
+		return sse2_whitespace(pos, end);
+	}
+
+	__attribute__((target("avx2")))
+	const char* avx2_ident(const char* pos, const char* end) {
+		while (end - pos >= 32) {
+			auto chars { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos)) };
+			auto hit { _mm256_or_si256(
+				_mm256_or_si256(in_range_32(chars, 'a', 'z'), in_range_32(chars, 'A', 'Z')),
+				in_range_32(chars, '0', '9')
+			) };
+			unsigned miss { ~static_cast<unsigned>(_mm256_movemask_epi8(hit)) };
+			if (miss) { return pos + __builtin_ctz(miss); }
+			pos += 32;
+		}
+		return sse2_ident(pos, end);
+	}
+#endif
+
+	struct Skippers {
+		Skipper whitespace { scalar_whitespace };
+		Skipper ident { scalar_ident };
+
+		Skippers() {
+#ifdef CHARS_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) {
+				whitespace = avx2_whitespace; ident = avx2_ident;
+			} else if (__builtin_cpu_supports("sse2")) {
+				whitespace = sse2_whitespace; ident = sse2_ident;
+			}
+#endif
+		}
+	};
+
+	const Skippers skippers;
+}
+
+const char* skip_whitespace(const char* pos, const char* end) {
+	return skippers.whitespace(pos, end);
+}
+
+const char* skip_ident_chars(const char* pos, const char* end) {
+	return skippers.ident(pos, end);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Character classes of the scanner, looked up in a single table instead
+// of the comparison chains in Scanner_isLetter and friends.
+
+constexpr std::uint8_t char_whitespace { 0x01 };
+constexpr std::uint8_t char_letter { 0x02 };
+constexpr std::uint8_t char_digit { 0x04 };
+constexpr std::uint8_t char_hex_letter { 0x08 };
+
+constexpr auto build_char_classes() {
+	std::array<std::uint8_t, 256> table { };
+	for (int ch : { ' ', '\t', '\n', '\v', '\f', '\r' }) {
+		table[ch] |= char_whitespace;
+	}
+	for (int ch { 'a' }; ch <= 'z'; ++ch) { table[ch] |= char_letter; }
+	for (int ch { 'A' }; ch <= 'Z'; ++ch) { table[ch] |= char_letter; }
+	for (int ch { '0' }; ch <= '9'; ++ch) { table[ch] |= char_digit; }
+	for (int ch { 'A' }; ch <= 'F'; ++ch) { table[ch] |= char_hex_letter; }
+	return table;
+}
+
+constexpr auto char_classes { build_char_classes() };
+
+constexpr bool char_is(char ch, std::uint8_t classes) {
+	return char_classes[static_cast<unsigned char>(ch)] & classes;
+}
+
+constexpr bool is_whitespace(char ch) { return char_is(ch, char_whitespace); }
+constexpr bool is_letter(char ch) { return char_is(ch, char_letter); }
+constexpr bool is_digit(char ch) { return char_is(ch, char_digit); }
+constexpr bool is_hex_letter(char ch) { return char_is(ch, char_hex_letter); }
+constexpr bool is_ident_char(char ch) {
+	return char_is(ch, char_letter | char_digit);
+}
+
+// Return the first position in [pos, end) that doesn't belong to the run.
+// Long runs are consumed 16 or 32 bytes at a time if the CPU supports it.
+const char* skip_whitespace(const char* pos, const char* end);
+const char* skip_ident_chars(const char* pos, const char* end);
@@ -0,0 +1,2449 @@
+#include "emit.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "Token.h"
+#include "interface.h"
+#include "ranges.h"
+
+namespace {
+	using Error = std::runtime_error;
+
+	class Emitter {
+		private:
+			const Module& module_;
+			const std::vector<const ModuleInterface*>& imports_;
+			std::string& h_;
+			std::string& cxx_;
+			EmitMode mode_;
+			bool checked_;
+			const std::set<std::string>* keep_;
+			std::string* checks_;
+			bool simd_;
+			Facts facts_;
+			std::size_t temporaries_ { 0 };
+			std::size_t emitted_checks_ { 0 };
+			int level_ { 1 };
+			std::vector<Position> line_starts_;
+			std::vector<const ProcDecl*> procedures_;
+			// variables of enclosing type CASE branches and the types of
+			// their labels
+			std::vector<std::pair<const QualIdent*, const QualIdent*>> narrowed_;
+			std::vector<std::string_view> strings_;
+			std::map<std::string_view, std::size_t> string_ids_;
+
+		public:
+			Emitter(
+				const Module& module, const std::vector<const ModuleInterface*>& imports,
+				std::string& h, std::string& cxx, const EmitOptions& options,
+				const std::set<std::string>* keep
+			):
+				module_ { module }, imports_ { imports }, h_ { h }, cxx_ { cxx },
+				mode_ { options.mode }, checked_ { options.checked }, keep_ { keep },
+				checks_ { options.checks }, simd_ { options.simd }
+			{ }
+
+			void module();
+
+		private:
+			void indent(std::string& out) const;
+			void name(std::string& out, const Name& name) const;
+			void qual_ident(std::string& out, const QualIdent& ident) const;
+			bool kept(const Name& name) const;
+			void source_position(std::string& out, Position pos, bool quoted = true);
+			Facts procedure_facts(const ProcDecl* procedure);
+
+			const ModuleInterface* imported(const Name& alias) const;
+			const Type* variable_type(const Expr* expr) const;
+			const QualIdent* narrowed(const QualIdent& ident) const;
+			const Signature* procedure_signature(const Expr* expr) const;
+			const Type* named_type(const QualIdent& ident) const;
+			const Type* resolve(const Type* type) const;
+			bool is_record(const Type* type) const;
+			bool is_pointer(const Type* type) const;
+			bool has_pointers(const Type* type) const;
+			void record_name(std::string& out, const QualIdent& ident) const;
+			void pointer_record(std::string& out, const Type* type) const;
+			const Type* declared_type(const Expr* expr) const;
+			const Type* expression_type(const Expr* expr) const;
+			bool is_char(const Expr* expr) const;
+			bool is_set(const Expr* expr) const;
+			bool is_char_array(const Expr* expr) const;
+
+			void declarations(const Declarations& declarations, bool global);
+			void const_declaration(std::string& out, const ConstDecl& decl);
+			void type_declaration(std::string& out, const TypeDecl& decl, bool global);
+			void record_declaration(std::string& out, const std::string& name, const RecordType& record, bool global);
+			void global_roots();
+			void variable_declaration(const VarDecl& decl, bool global);
+			void procedure_prototypes(const Declarations& declarations, bool global);
+			void procedure_declaration(const ProcDecl& procedure, bool global);
+			void signature(std::string& out, const Name& name, const Signature& signature);
+			void type(std::string& out, const Type* type, bool read_only = false);
+			void record_type(std::string& out, const RecordType& record, int level);
+
+			void statements(const Statements& statements);
+			void statement(const Stmt* statement);
+			void if_statement(const IfStmt& statement);
+			void case_statement(const CaseStmt& statement);
+			void type_case_statement(const CaseStmt& statement);
+			void while_statement(const WhileStmt& statement);
+			void repeat_statement(const RepeatStmt& statement);
+			void for_statement(const ForStmt& statement);
+			bool independent_iterations(const ForStmt& statement) const;
+
+			void expression(std::string& out, const Expr* expr, bool as_char = false);
+			void literal(std::string& out, const Literal& literal);
+			void constant(std::string& out, const Value& value, bool as_char);
+			void call(std::string& out, const Call& call);
+			bool is_guard(const Call& call) const;
+			bool record_parameter(const Expr* expr) const;
+			void type_tag(std::string& out, const Expr* expr);
+			void index(std::string& out, const Index& index);
+			void set_check(std::string& out, std::initializer_list<const Expr*> elements);
+			void string_pool(std::string& out) const;
+			void binary(std::string& out, const Binary& binary);
+			void set_binary(std::string& out, const Binary& binary);
+			bool membership(std::string& out, const Binary& binary);
+	};
+
+	void Emitter::indent(std::string& out) const {
+		out.append(level_, '\t');
+	}
+
+	void Emitter::name(std::string& out, const Name& name) const {
+		out += module_.name.text();
+		out += '_';
+		out += name.text();
+	}
+
+	void Emitter::qual_ident(std::string& out, const QualIdent& ident) const {
+		if (!ident.module.empty()) {
+			auto full_name { ident.module };
+			for (const auto& import : module_.imports) {
+				if (import.alias == ident.module) { full_name = import.module; break; }
+			}
+			out += full_name.text();
+			out += '_';
+			out += ident.name.text();
+			return;
+		}
+		auto text { ident.name.text() };
+		if (text == "INTEGER" || text == "REAL" || text == "CHAR" || text == "BOOLEAN" || text == "SET") {
+			out += "SYSTEM_";
+			out += text;
+		} else {
+			name(out, ident.name);
+		}
+	}
+
+	bool Emitter::kept(const Name& name) const {
+		if (!keep_) { return true; }
+		std::string qualified { module_.name.text() };
+		qualified += '.';
+		qualified += name.text();
+		return keep_->count(qualified) != 0;
+	}
+
+	// "Module.Mod:line:column", quoted for trap messages
+	void Emitter::source_position(std::string& out, Position pos, bool quoted) {
+		if (line_starts_.empty()) {
+			line_starts_.push_back(0);
+			for (Position i { 0 }; i < module_.source.size(); ++i) {
+				if (module_.source[i] == '\n') { line_starts_.push_back(i + 1); }
+			}
+		}
+		auto line { std::upper_bound(line_starts_.begin(), line_starts_.end(), pos) };
+		if (quoted) { out += '"'; }
+		out += module_.name.text();
+		out += ".Mod:";
+		out += std::to_string(line - line_starts_.begin());
+		out += ':';
+		out += std::to_string(pos - *(line - 1) + 1);
+		if (quoted) { out += '"'; }
+	}
+
+	// no facts yet about the variables of the procedure, or the module
+	// body for nullptr
+	Facts Emitter::procedure_facts(const ProcDecl* procedure) {
+		auto lookup = [this](const Expr* expr) { return procedure_signature(expr); };
+		std::set<std::string_view> locals;
+		bool aliasing { false };
+		if (procedure) {
+			for (const auto& section : procedure->signature->sections) {
+				aliasing = aliasing || section.reference;
+				for (const auto& ident : section.names) {
+					if (!section.reference) { locals.insert(ident.name.text()); }
+				}
+			}
+			for (const auto* decl : procedure->declarations.vars) {
+				for (const auto& ident : decl->names) { locals.insert(ident.name.text()); }
+			}
+		}
+		return { lookup, std::move(locals), aliasing };
+	}
+
+	bool is_char_type(const Type* type) {
+		if (!type || type->kind != TypeKind::named) { return false; }
+		const auto& ident { static_cast<const NamedType*>(type)->ident };
+		return ident.module.empty() && ident.name.text() == "CHAR";
+	}
+
+	bool is_set_type(const Type* type) {
+		if (!type || type->kind != TypeKind::named) { return false; }
+		const auto& ident { static_cast<const NamedType*>(type)->ident };
+		return ident.module.empty() && ident.name.text() == "SET";
+	}
+
+	void char_literal(std::string& out, std::int64_t ch) {
+		static constexpr char digits[] { "0123456789ABCDEF" };
+		out += '\'';
+		if (ch >= ' ' && ch <= '~' && ch != '\'' && ch != '\\') {
+			out += static_cast<char>(ch);
+		} else {
+			out += "\\x";
+			out += digits[(ch >> 4) & 0xf];
+			out += digits[ch & 0xf];
+		}
+		out += '\'';
+	}
+
+	void string_literal(std::string& out, std::string_view text) {
+		static constexpr char digits[] { "01234567" };
+		out += '"';
+		for (char ch : text) {
+			if (ch == '\\' || static_cast<unsigned char>(ch) < ' ') {
+				out += '\\';
+				out += digits[(ch >> 6) & 3];
+				out += digits[(ch >> 3) & 7];
+				out += digits[ch & 7];
+			} else {
+				out += ch;
+			}
+		}
+		out += '"';
+	}
+
+	// names from interfaces are qualified by module, not by alias
+	const ModuleInterface* Emitter::imported(const Name& alias) const {
+		for (std::size_t i { 0 }; i < imports_.size(); ++i) {
+			if (module_.imports[i].alias == alias) { return imports_[i]; }
+		}
+		for (std::size_t i { 0 }; i < imports_.size(); ++i) {
+			if (module_.imports[i].module.text() == alias.text()) { return imports_[i]; }
+		}
+		return nullptr;
+	}
+
+	// the label type of a variable in a type CASE branch, or nullptr
+	const QualIdent* Emitter::narrowed(const QualIdent& ident) const {
+		if (!ident.module.empty()) { return nullptr; }
+		for (auto it { narrowed_.rbegin() }; it != narrowed_.rend(); ++it) {
+			if (it->first->name == ident.name) { return it->second; }
+		}
+		return nullptr;
+	}
+
+	// declared type of a variable or parameter, in a type CASE branch the
+	// type of its label; nullptr if unknown
+	const Type* Emitter::variable_type(const Expr* expr) const {
+		if (expr->kind != ExprKind::ident) { return nullptr; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		if (auto label { narrowed(ident) }) { return named_type(*label); }
+		if (!ident.module.empty()) {
+			auto interface { imported(ident.module) };
+			if (!interface) { return nullptr; }
+			auto got { interface->vars.find(ident.name.text()) };
+			return got != interface->vars.end() ? got->second : nullptr;
+		}
+		auto search = [&](const Declarations& declarations) -> const Type* {
+			for (const auto* decl : declarations.vars) {
+				for (const auto& name : decl->names) {
+					if (name.name == ident.name) { return decl->type; }
+				}
+			}
+			return nullptr;
+		};
+		for (auto it { procedures_.rbegin() }; it != procedures_.rend(); ++it) {
+			for (const auto& section : (*it)->signature->sections) {
+				for (const auto& name : section.names) {
+					if (name.name == ident.name) { return section.type; }
+				}
+			}
+			if (auto type { search((*it)->declarations) }) { return type; }
+		}
+		return search(module_.declarations);
+	}
+
+	const Signature* Emitter::procedure_signature(const Expr* expr) const {
+		if (expr->kind != ExprKind::ident) { return nullptr; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		if (!ident.module.empty()) {
+			auto interface { imported(ident.module) };
+			if (!interface) { return nullptr; }
+			auto got { interface->procedures.find(ident.name.text()) };
+			return got != interface->procedures.end() ? got->second : nullptr;
+		}
+		auto search = [&](const Declarations& declarations) -> const Signature* {
+			for (const auto* procedure : declarations.procedures) {
+				if (procedure->ident.name == ident.name) { return procedure->signature; }
+			}
+			return nullptr;
+		};
+		for (auto it { procedures_.rbegin() }; it != procedures_.rend(); ++it) {
+			if (auto signature { search((*it)->declarations) }) { return signature; }
+		}
+		return search(module_.declarations);
+	}
+
+	// Element type and number of dimensions of an array type, counting
+	// the dimensions of anonymous element arrays: ARRAY 2 OF ARRAY 3 OF T
+	// has two like ARRAY 2, 3 OF T. rank is 0 for other types.
+	const Type* array_element(const Type* type, std::uint32_t& rank) {
+		rank = 0;
+		if (type->kind == TypeKind::array) {
+			do {
+				const auto& array { *static_cast<const ArrayType*>(type) };
+				rank += array.lengths.size();
+				type = array.element;
+			} while (type->kind == TypeKind::array);
+		} else if (type->kind == TypeKind::open_array) {
+			do {
+				++rank;
+				type = static_cast<const OpenArrayType*>(type)->element;
+			} while (type->kind == TypeKind::open_array);
+		}
+		return type;
+	}
+
+	// a[i][j] is a[i, j]; returns a
+	const Expr* index_chain(const Index& index, std::vector<const Expr*>& indices) {
+		const Expr* base { &index };
+		while (base->kind == ExprKind::index) {
+			const auto& inner { *static_cast<const Index*>(base) };
+			indices.insert(indices.begin(), inner.indices.begin(), inner.indices.end());
+			base = inner.base;
+		}
+		return base;
+	}
+
+	// the type declared for a type name; nullptr if it is unknown or
+	// predeclared
+	const Type* Emitter::named_type(const QualIdent& ident) const {
+		if (!ident.module.empty()) {
+			auto interface { imported(ident.module) };
+			if (!interface) { return nullptr; }
+			auto got { interface->types.find(ident.name.text()) };
+			return got != interface->types.end() ? got->second : nullptr;
+		}
+		auto search = [&](const Declarations& declarations) -> const Type* {
+			for (const auto* decl : declarations.types) {
+				if (decl->ident.name == ident.name) { return decl->type; }
+			}
+			return nullptr;
+		};
+		for (auto it { procedures_.rbegin() }; it != procedures_.rend(); ++it) {
+			if (auto type { search((*it)->declarations) }) { return type; }
+		}
+		return search(module_.declarations);
+	}
+
+	// follows type names to the type they stand for; nullptr if unknown
+	const Type* Emitter::resolve(const Type* type) const {
+		while (type && type->kind == TypeKind::named) {
+			const auto& ident { static_cast<const NamedType*>(type)->ident };
+			auto found { named_type(ident) };
+			// names in an interface are qualified by module, not by alias
+			if (!ident.module.empty()) { return found; }
+			if (!found) {
+				// predeclared
+				return type;
+			}
+			type = found;
+		}
+		return type;
+	}
+
+	bool Emitter::is_record(const Type* type) const {
+		auto resolved { resolve(type) };
+		return resolved && resolved->kind == TypeKind::record;
+	}
+
+	bool Emitter::is_pointer(const Type* type) const {
+		auto resolved { resolve(type) };
+		return resolved && resolved->kind == TypeKind::pointer;
+	}
+
+	// values of the type hold pointers the collector has to trace
+	bool Emitter::has_pointers(const Type* type) const {
+		type = resolve(type);
+		if (!type) { return false; }
+		switch (type->kind) {
+			case TypeKind::pointer:
+				return true;
+			case TypeKind::array: case TypeKind::open_array: {
+				std::uint32_t rank;
+				return has_pointers(array_element(type, rank));
+			}
+			case TypeKind::record: {
+				const auto& record { *static_cast<const RecordType*>(type) };
+				if (record.base && has_pointers(record.base)) { return true; }
+				for (const auto& fields : record.fields) {
+					if (has_pointers(fields.type)) { return true; }
+				}
+				return false;
+			}
+			default:
+				return false;
+		}
+	}
+
+	// the struct of the record type named ident, or of the records a
+	// pointer type of that name points to
+	void Emitter::record_name(std::string& out, const QualIdent& ident) const {
+		auto type { named_type(ident) };
+		if (type && type->kind == TypeKind::named) {
+			record_name(out, static_cast<const NamedType*>(type)->ident);
+			return;
+		}
+		if (type && type->kind == TypeKind::pointer) {
+			auto target { static_cast<const PointerType*>(type)->target };
+			if (target->kind == TypeKind::named) {
+				record_name(out, static_cast<const NamedType*>(target)->ident);
+			} else {
+				qual_ident(out, ident);
+				out += "_record";
+			}
+			return;
+		}
+		qual_ident(out, ident);
+	}
+
+	// the struct a pointer of the declared type points to
+	void Emitter::pointer_record(std::string& out, const Type* type) const {
+		if (type && type->kind == TypeKind::named) {
+			record_name(out, static_cast<const NamedType*>(type)->ident);
+		} else if (type && type->kind == TypeKind::pointer &&
+			static_cast<const PointerType*>(type)->target->kind == TypeKind::named
+		) {
+			record_name(out, static_cast<const NamedType*>(static_cast<const PointerType*>(type)->target)->ident);
+		} else {
+			throw Error { "pointer to a named record type expected" };
+		}
+	}
+
+	// type of a designator as declared, before following type names;
+	// nullptr if unknown
+	const Type* Emitter::declared_type(const Expr* expr) const {
+		switch (expr->kind) {
+			case ExprKind::ident:
+				return variable_type(expr);
+			case ExprKind::paren:
+				return declared_type(static_cast<const Paren*>(expr)->inner);
+			case ExprKind::index: {
+				std::vector<const Expr*> indices;
+				auto type { declared_type(index_chain(*static_cast<const Index*>(expr), indices)) };
+				for (auto remaining { indices.size() }; type && remaining;) {
+					std::uint32_t rank { 0 };
+					type = resolve(type);
+					if (!type) { return nullptr; }
+					auto element { array_element(type, rank) };
+					// a row has no declared type
+					if (!rank || remaining < rank) { return nullptr; }
+					remaining -= rank;
+					type = element;
+				}
+				return type;
+			}
+			case ExprKind::field: {
+				// fields of imported records have names of another module
+				const auto& field { *static_cast<const Field*>(expr) };
+				auto type { resolve(declared_type(field.base)) };
+				if (type && type->kind == TypeKind::pointer) {
+					type = resolve(static_cast<const PointerType*>(type)->target);
+				}
+				while (type && type->kind == TypeKind::record) {
+					const auto& record { *static_cast<const RecordType*>(type) };
+					for (const auto& fields : record.fields) {
+						for (const auto& ident : fields.names) {
+							if (ident.name.text() == field.field.text()) { return fields.type; }
+						}
+					}
+					type = resolve(record.base);
+				}
+				return nullptr;
+			}
+			case ExprKind::deref: {
+				auto type { resolve(declared_type(static_cast<const Deref*>(expr)->base)) };
+				return type && type->kind == TypeKind::pointer ? static_cast<const PointerType*>(type)->target : nullptr;
+			}
+			case ExprKind::call: {
+				const auto& call { *static_cast<const Call*>(expr) };
+				if (!is_guard(call)) { return nullptr; }
+				return named_type(static_cast<const Ident*>(call.arguments[0])->ident);
+			}
+			default:
+				return nullptr;
+		}
+	}
+
+	// type of a designator; nullptr if unknown
+	const Type* Emitter::expression_type(const Expr* expr) const {
+		return resolve(declared_type(expr));
+	}
+
+	bool Emitter::is_char(const Expr* expr) const {
+		switch (expr->kind) {
+			case ExprKind::index:
+				return is_char_type(expression_type(expr));
+			case ExprKind::constant:
+				return static_cast<const Constant*>(expr)->value.kind == ValueKind::character;
+			case ExprKind::ident:
+				return is_char_type(variable_type(expr));
+			case ExprKind::paren:
+				return is_char(static_cast<const Paren*>(expr)->inner);
+			case ExprKind::call: {
+				const auto& call { *static_cast<const Call*>(expr) };
+				if (call.procedure->kind == ExprKind::ident) {
+					const auto& ident { static_cast<const Ident*>(call.procedure)->ident };
+					if (ident.module.empty() && ident.name.text() == "CHR") { return true; }
+				}
+				auto signature { procedure_signature(call.procedure) };
+				return signature && is_char_type(signature->result);
+			}
+			default:
+				return false;
+		}
+	}
+
+	bool Emitter::is_set(const Expr* expr) const {
+		switch (expr->kind) {
+			case ExprKind::set:
+				return true;
+			case ExprKind::index:
+				return is_set_type(expression_type(expr));
+			case ExprKind::constant:
+				return static_cast<const Constant*>(expr)->value.kind == ValueKind::set;
+			case ExprKind::ident:
+				return is_set_type(variable_type(expr));
+			case ExprKind::paren:
+				return is_set(static_cast<const Paren*>(expr)->inner);
+			case ExprKind::unary:
+				return is_set(static_cast<const Unary*>(expr)->operand);
+			case ExprKind::binary: {
+				const auto& binary { *static_cast<const Binary*>(expr) };
+				bool arithmetic {
+					binary.op == Token_plus || binary.op == Token_minus ||
+					binary.op == Token_star || binary.op == Token_slash
+				};
+				return arithmetic && is_set(binary.left);
+			}
+			case ExprKind::call: {
+				auto signature { procedure_signature(static_cast<const Call*>(expr)->procedure) };
+				return signature && is_set_type(signature->result);
+			}
+			default:
+				return false;
+		}
+	}
+
+	// a designator of an ARRAY OF CHAR, which holds a string
+	bool Emitter::is_char_array(const Expr* expr) const {
+		auto type { expression_type(expr) };
+		if (!type || (type->kind != TypeKind::array && type->kind != TypeKind::open_array)) { return false; }
+		std::uint32_t rank;
+		auto element { array_element(type, rank) };
+		return rank == 1 && is_char_type(element);
+	}
+
+	void Emitter::module() {
+		bool linked { mode_ != EmitMode::modular };
+		if (mode_ != EmitMode::unity) {
+			h_ += "#pragma once\n\n#include \"SYSTEM.h\"\n\n";
+			cxx_ += "#include \"";
+			cxx_ += module_.name.text();
+			cxx_ += ".h\"\n\n";
+		}
+		auto pool_position { cxx_.size() };
+
+		bool has_imports { false };
+		for (const auto& import : module_.imports) {
+			if (import.module.text() == "SYSTEM" || mode_ == EmitMode::unity) { continue; }
+			h_ += "#include \"";
+			h_ += import.module.text();
+			h_ += ".h\"\n";
+			has_imports = true;
+		}
+		if (has_imports) { h_ += "\n"; }
+
+		if (!linked) {
+			cxx_ += "static void init_module_imports() noexcept {\n";
+			for (const auto& import : module_.imports) {
+				if (import.module.text() == "SYSTEM") { continue; }
+				indent(cxx_);
+				cxx_ += import.module.text();
+				cxx_ += "_init_module();\n";
+			}
+			cxx_ += "}\n\n";
+		}
+
+		declarations(module_.declarations, true);
+		global_roots();
+
+		if (!linked || !module_.body.empty()) {
+			h_ += "void ";
+			h_ += module_.name.text();
+			h_ += "_init_module() noexcept;\n";
+			cxx_ += "void ";
+			cxx_ += module_.name.text();
+			cxx_ += "_init_module() noexcept {\n";
+			if (!linked) {
+				indent(cxx_); cxx_ += "static bool already_run { false };\n";
+				indent(cxx_); cxx_ += "if (already_run) { return; }\n";
+				indent(cxx_); cxx_ += "already_run = true;\n";
+				indent(cxx_); cxx_ += "init_module_imports();\n";
+			}
+			facts_ = procedure_facts(nullptr);
+			temporaries_ = 0;
+			statements(module_.body);
+			cxx_ += "}\n";
+		}
+
+		std::string pool;
+		string_pool(pool);
+		cxx_.insert(pool_position, pool);
+	}
+
+	// string literals with more than one character, each one once
+	void Emitter::string_pool(std::string& out) const {
+		for (std::size_t i { 0 }; i < strings_.size(); ++i) {
+			out += "static constexpr Oberon_String ";
+			out += module_.name.text();
+			out += "_string_";
+			out += std::to_string(i);
+			out += " { ";
+			string_literal(out, strings_[i]);
+			out += ", ";
+			out += std::to_string(strings_[i].size());
+			out += " };\n";
+		}
+		if (!strings_.empty()) { out += "\n"; }
+	}
+
+	// Global declarations go to the header, local ones into the body of
+	// their procedure. Local procedures can only access their own and
+	// global names, so they are emitted before the enclosing procedure.
+	void Emitter::declarations(const Declarations& declarations, bool global) {
+		for (const auto* decl : declarations.consts) {
+			if (!global) { indent(cxx_); }
+			const_declaration(global ? h_ : cxx_, *decl);
+		}
+		for (const auto* decl : declarations.types) {
+			if (global && !kept(decl->ident.name)) { continue; }
+			if (!global) { indent(cxx_); }
+			type_declaration(global ? h_ : cxx_, *decl, global);
+		}
+		for (const auto* decl : declarations.vars) {
+			variable_declaration(*decl, global);
+		}
+		if (global) {
+			procedure_prototypes(declarations, true);
+			for (const auto* procedure : declarations.procedures) {
+				if (!kept(procedure->ident.name)) { continue; }
+				procedure_declaration(*procedure, true);
+			}
+		}
+	}
+
+	// Procedures may be called before their definition. Exported ones are
+	// declared in the header, the others here; they need not be used.
+	void Emitter::procedure_prototypes(const Declarations& declarations, bool global) {
+		for (const auto* procedure : declarations.procedures) {
+			if (global && !kept(procedure->ident.name)) { continue; }
+			procedure_prototypes(procedure->declarations, false);
+			if (global && procedure->ident.exported) { continue; }
+			cxx_ += "[[maybe_unused]] static auto ";
+			signature(cxx_, procedure->ident.name, *procedure->signature);
+			cxx_ += ";\n";
+		}
+	}
+
+	// constants have the C++ type of their Oberon type
+	void Emitter::const_declaration(std::string& out, const ConstDecl& decl) {
+		if (decl.value->kind != ExprKind::constant) { throw Error { "constant expression expected" }; }
+		const auto& value { static_cast<const Constant*>(decl.value)->value };
+		switch (value.kind) {
+			case ValueKind::integer: out += "constexpr SYSTEM_INTEGER "; break;
+			case ValueKind::real: out += "constexpr SYSTEM_REAL "; break;
+			case ValueKind::boolean: out += "constexpr SYSTEM_BOOLEAN "; break;
+			case ValueKind::character: out += "constexpr SYSTEM_CHAR "; break;
+			case ValueKind::set: out += "constexpr SYSTEM_SET "; break;
+			case ValueKind::string: out += "constexpr Oberon_String "; break;
+		}
+		name(out, decl.ident.name);
+		out += " { ";
+		if (value.kind == ValueKind::string) {
+			// the string pool is local to the translation unit
+			string_literal(out, value.string);
+			out += ", ";
+			out += std::to_string(value.string.size());
+		} else {
+			constant(out, value, false);
+		}
+		out += " };\n";
+	}
+
+	// The records of POINTER TO RECORD ... END are named after the pointer
+	// type. Records declared later in the scope are declared before
+	// pointers to them.
+	void Emitter::type_declaration(std::string& out, const TypeDecl& decl, bool global) {
+		std::string struct_name;
+		name(struct_name, decl.ident.name);
+		if (decl.type->kind == TypeKind::record) {
+			record_declaration(out, struct_name, static_cast<const RecordType&>(*decl.type), global);
+			return;
+		}
+		if (decl.type->kind == TypeKind::pointer) {
+			auto target { static_cast<const PointerType*>(decl.type)->target };
+			if (target->kind == TypeKind::record) {
+				// the record may point to its own type
+				auto pointer_name { struct_name };
+				struct_name += "_record";
+				out += "struct ";
+				out += struct_name;
+				out += ";\n";
+				if (!global) { indent(out); }
+				out += "using ";
+				out += pointer_name;
+				out += " = ";
+				out += struct_name;
+				out += "*;\n";
+				if (!global) { indent(out); }
+				record_declaration(out, struct_name, static_cast<const RecordType&>(*target), global);
+				return;
+			}
+			const auto& ident { static_cast<const NamedType*>(target)->ident };
+			auto declared { ident.module.empty() ? named_type(ident) : nullptr };
+			if (declared && declared->kind == TypeKind::record) {
+				out += "struct ";
+				qual_ident(out, ident);
+				out += ";\n";
+				if (!global) { indent(out); }
+			}
+		}
+		out += "using ";
+		out += struct_name;
+		out += " = ";
+		type(out, decl.type);
+		out += ";\n";
+	}
+
+	// Record types get a type descriptor next to them, with a function
+	// to trace their pointers if they have any.
+	void Emitter::record_declaration(
+		std::string& out, const std::string& name, const RecordType& record, bool global
+	) {
+		out += "struct ";
+		out += name;
+		record_type(out, record, global ? 0 : level_);
+		out += ";\n";
+		if (!global) { indent(out); }
+		out += global ? "inline " : "static ";
+		out += "constexpr SYSTEM_Type_Descriptor ";
+		out += name;
+		out += "_descriptor { ";
+		if (record.base) {
+			record_name(out, static_cast<const NamedType*>(record.base)->ident);
+			out += "_descriptor, ";
+		}
+		out += "&";
+		out += name;
+		out += "_descriptor";
+		if (has_pointers(&record)) {
+			out += ", SYSTEM_trace_object<";
+			out += name;
+			out += ">";
+		}
+		out += " };\n";
+	}
+
+	// The global variables that hold pointers are the roots of the
+	// collector; the module registers a function tracing them at startup.
+	void Emitter::global_roots() {
+		std::string traces;
+		for (const auto* decl : module_.declarations.vars) {
+			if (!has_pointers(decl->type)) { continue; }
+			for (const auto& ident : decl->names) {
+				if (!kept(ident.name)) { continue; }
+				traces += "\tSYSTEM_trace(";
+				name(traces, ident.name);
+				traces += ");\n";
+			}
+		}
+		if (traces.empty()) { return; }
+		auto module { module_.name.text() };
+		cxx_ += "static void ";
+		cxx_ += module;
+		cxx_ += "_trace_globals() noexcept {\n";
+		cxx_ += traces;
+		cxx_ += "}\n[[maybe_unused]] static const bool ";
+		cxx_ += module;
+		cxx_ += "_roots { SYSTEM_add_roots(";
+		cxx_ += module;
+		cxx_ += "_trace_globals) };\n";
+	}
+
+	void Emitter::variable_declaration(const VarDecl& decl, bool global) {
+		std::string names;
+		const char* separator { "" };
+		for (const auto& ident : decl.names) {
+			if (global && !kept(ident.name)) { continue; }
+			names += separator;
+			name(names, ident.name);
+			separator = ", ";
+		}
+		if (names.empty()) { return; }
+		if (global) {
+			h_ += "extern ";
+			type(h_, decl.type);
+			h_ += " ";
+			h_ += names;
+			h_ += ";\n";
+		} else {
+			indent(cxx_);
+		}
+		type(cxx_, decl.type);
+		cxx_ += " ";
+		cxx_ += names;
+		cxx_ += ";\n";
+	}
+
+	constexpr std::size_t inline_statements { 4 };
+
+	bool calls(const Expr* expr) {
+		if (!expr) { return false; }
+		switch (expr->kind) {
+			case ExprKind::call: return true;
+			case ExprKind::field: return calls(static_cast<const Field*>(expr)->base);
+			case ExprKind::deref: return calls(static_cast<const Deref*>(expr)->base);
+			case ExprKind::paren: return calls(static_cast<const Paren*>(expr)->inner);
+			case ExprKind::unary: return calls(static_cast<const Unary*>(expr)->operand);
+			case ExprKind::set:
+				for (const auto& element : static_cast<const SetExpr*>(expr)->elements) {
+					if (calls(element.low) || calls(element.high)) { return true; }
+				}
+				return false;
+			case ExprKind::binary: {
+				const auto& binary { *static_cast<const Binary*>(expr) };
+				return calls(binary.left) || calls(binary.right);
+			}
+			case ExprKind::index: {
+				const auto& index { *static_cast<const Index*>(expr) };
+				if (calls(index.base)) { return true; }
+				for (const auto* item : index.indices) {
+					if (calls(item)) { return true; }
+				}
+				return false;
+			}
+			default: return false;
+		}
+	}
+
+	// counts the statements down to limit; false if one of them calls a
+	// procedure
+	bool count_leaf_statements(const Statements& statements, std::size_t& count) {
+		for (const auto* statement : statements) {
+			if (++count > inline_statements) { return false; }
+			switch (statement->kind) {
+				case StmtKind::assignment: {
+					const auto& assignment { *static_cast<const Assignment*>(statement) };
+					if (calls(assignment.target) || calls(assignment.value)) { return false; }
+					break;
+				}
+				case StmtKind::call:
+					return false;
+				case StmtKind::if_then: {
+					const auto& if_stmt { *static_cast<const IfStmt*>(statement) };
+					for (const auto& branch : if_stmt.branches) {
+						if (calls(branch.condition) || !count_leaf_statements(branch.body, count)) {
+							return false;
+						}
+					}
+					if (!count_leaf_statements(if_stmt.otherwise, count)) { return false; }
+					break;
+				}
+				case StmtKind::case_of: {
+					const auto& case_stmt { *static_cast<const CaseStmt*>(statement) };
+					if (calls(case_stmt.selector)) { return false; }
+					for (const auto& item : case_stmt.cases) {
+						if (!count_leaf_statements(item.body, count)) { return false; }
+					}
+					if (!count_leaf_statements(case_stmt.otherwise, count)) { return false; }
+					break;
+				}
+				case StmtKind::while_do:
+					for (const auto& branch : static_cast<const WhileStmt*>(statement)->branches) {
+						if (calls(branch.condition) || !count_leaf_statements(branch.body, count)) {
+							return false;
+						}
+					}
+					break;
+				case StmtKind::repeat_until: {
+					const auto& repeat { *static_cast<const RepeatStmt*>(statement) };
+					if (calls(repeat.condition) || !count_leaf_statements(repeat.body, count)) {
+						return false;
+					}
+					break;
+				}
+				case StmtKind::for_do: {
+					const auto& for_stmt { *static_cast<const ForStmt*>(statement) };
+					if (calls(for_stmt.begin) || calls(for_stmt.end) ||
+						!count_leaf_statements(for_stmt.body, count)
+					) {
+						return false;
+					}
+					break;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool is_small_leaf(const ProcDecl& procedure) {
+		if (!procedure.declarations.procedures.empty() || calls(procedure.result)) {
+			return false;
+		}
+		std::size_t count { 0 };
+		return count_leaf_statements(procedure.body, count);
+	}
+
+	void Emitter::procedure_declaration(const ProcDecl& procedure, bool global) {
+		procedures_.push_back(&procedure);
+		for (const auto* local : procedure.declarations.procedures) {
+			procedure_declaration(*local, false);
+		}
+
+		// only exported procedures have external linkage; small exported
+		// leaf procedures are defined in the header, so importers can
+		// inline them. The linkage is known only after the body is
+		// emitted, as the body may add to the string pool.
+		bool exported { global && procedure.ident.exported };
+		bool try_inline { exported && is_small_leaf(procedure) };
+		auto start { cxx_.size() };
+		auto pooled_strings { strings_.size() };
+		cxx_ += "auto ";
+		signature(cxx_, procedure.ident.name, *procedure.signature);
+		cxx_ += " {\n";
+
+		declarations(procedure.declarations, false);
+		auto outer_facts { std::move(facts_) };
+		facts_ = procedure_facts(&procedure);
+		temporaries_ = 0;
+		statements(procedure.body);
+		if (procedure.result) {
+			facts_.effects(procedure.result);
+			indent(cxx_);
+			cxx_ += "return ";
+			expression(cxx_, procedure.result, is_char_type(procedure.signature->result));
+			cxx_ += ";\n";
+		}
+		cxx_ += "}\n";
+		facts_ = std::move(outer_facts);
+		procedures_.pop_back();
+
+		// the string pool is local to the translation unit
+		if (try_inline && strings_.size() == pooled_strings) {
+			h_ += "inline ";
+			h_.append(cxx_, start);
+			cxx_.resize(start);
+		} else if (exported) {
+			h_ += "auto ";
+			signature(h_, procedure.ident.name, *procedure.signature);
+			h_ += ";\n";
+		} else {
+			cxx_.insert(start, "static ");
+		}
+	}
+
+	void Emitter::signature(std::string& out, const Name& procedure, const Signature& signature) {
+		name(out, procedure);
+		out += "(";
+		const char* separator { "" };
+		for (const auto& section : signature.sections) {
+			for (const auto& ident : section.names) {
+				out += separator;
+				// open arrays are views, they are passed by value
+				bool open { section.type->kind == TypeKind::open_array };
+				type(out, section.type, open && !section.reference);
+				if (section.reference && !open) { out += "&"; }
+				out += " ";
+				name(out, ident.name);
+				// the dynamic type of VAR records
+				if (section.reference && is_record(section.type)) {
+					out += ", const SYSTEM_Type_Descriptor* ";
+					name(out, ident.name);
+					out += "_tag";
+				}
+				separator = ", ";
+			}
+		}
+		out += ") noexcept -> ";
+		if (signature.result) {
+			type(out, signature.result);
+		} else {
+			out += "void";
+		}
+	}
+
+	// read_only open arrays are value parameters
+	void Emitter::type(std::string& out, const Type* type, bool read_only) {
+		switch (type->kind) {
+			case TypeKind::named:
+				qual_ident(out, static_cast<const NamedType*>(type)->ident);
+				break;
+			case TypeKind::array: {
+				// one block for all dimensions
+				std::uint32_t rank;
+				out += "Oberon_Array<";
+				this->type(out, array_element(type, rank));
+				for (auto dimension { type }; dimension->kind == TypeKind::array;) {
+					const auto& array { *static_cast<const ArrayType*>(dimension) };
+					for (const auto* length : array.lengths) {
+						out += ", ";
+						expression(out, length);
+					}
+					dimension = array.element;
+				}
+				out += ">";
+				break;
+			}
+			case TypeKind::open_array: {
+				std::uint32_t rank;
+				out += read_only ? "Oberon_Open_Array<const " : "Oberon_Open_Array<";
+				this->type(out, array_element(type, rank));
+				if (rank > 1) {
+					out += ", ";
+					out += std::to_string(rank);
+				}
+				out += ">";
+				break;
+			}
+			case TypeKind::record:
+				out += "struct";
+				record_type(out, *static_cast<const RecordType*>(type), level_);
+				break;
+			case TypeKind::pointer:
+				pointer_record(out, type);
+				out += "*";
+				break;
+			default:
+				throw Error { "type not implemented" };
+		}
+	}
+
+	// extensions derive from their base type; level is the indentation
+	// of the declaration
+	void Emitter::record_type(std::string& out, const RecordType& record, int level) {
+		if (record.base) {
+			out += ": ";
+			record_name(out, static_cast<const NamedType*>(record.base)->ident);
+		}
+		out += " {\n";
+		bool traced { false };
+		for (const auto& fields : record.fields) {
+			out.append(level + 1, '\t');
+			type(out, fields.type);
+			const char* separator { " " };
+			for (const auto& ident : fields.names) {
+				out += separator;
+				out += ident.name.text();
+				separator = ", ";
+			}
+			out += ";\n";
+			traced = traced || has_pointers(fields.type);
+		}
+		// extensions without pointer fields inherit it
+		if (traced) {
+			out += "\n";
+			out.append(level + 1, '\t');
+			out += "void SYSTEM_trace() noexcept {\n";
+			if (record.base && has_pointers(record.base)) {
+				out.append(level + 2, '\t');
+				record_name(out, static_cast<const NamedType*>(record.base)->ident);
+				out += "::SYSTEM_trace();\n";
+			}
+			for (const auto& fields : record.fields) {
+				if (!has_pointers(fields.type)) { continue; }
+				for (const auto& ident : fields.names) {
+					out.append(level + 2, '\t');
+					out += "::SYSTEM_trace(";
+					out += ident.name.text();
+					out += ");\n";
+				}
+			}
+			out.append(level + 1, '\t');
+			out += "}\n";
+		}
+		out.append(level, '\t');
+		out += "}";
+	}
+
+	void Emitter::statements(const Statements& statements) {
+		for (const auto* statement : statements) {
+			this->statement(statement);
+		}
+	}
+
+	void Emitter::statement(const Stmt* statement) {
+		switch (statement->kind) {
+			case StmtKind::assignment: {
+				const auto& assignment { *static_cast<const Assignment*>(statement) };
+				facts_.effects(assignment.target);
+				facts_.effects(assignment.value);
+				indent(cxx_);
+				expression(cxx_, assignment.target);
+				cxx_ += " = ";
+				expression(cxx_, assignment.value, is_char(assignment.target));
+				cxx_ += ";\n";
+				facts_.assign(assignment.target, assignment.value);
+				break;
+			}
+			case StmtKind::call: {
+				// the arguments are evaluated before the call changes
+				// anything
+				const auto* call { static_cast<const CallStmt*>(statement)->call };
+				if (call->kind == ExprKind::call) {
+					for (const auto* argument : static_cast<const Call*>(call)->arguments) {
+						facts_.effects(argument);
+					}
+				}
+				indent(cxx_);
+				expression(cxx_, call);
+				if (call->kind != ExprKind::call) { cxx_ += "()"; }
+				cxx_ += ";\n";
+				facts_.effects(call);
+				break;
+			}
+			case StmtKind::if_then:
+				if_statement(*static_cast<const IfStmt*>(statement));
+				break;
+			case StmtKind::case_of: {
+				const auto& case_stmt { *static_cast<const CaseStmt*>(statement) };
+				if (case_stmt.type_test) {
+					type_case_statement(case_stmt);
+				} else {
+					case_statement(case_stmt);
+				}
+				break;
+			}
+			case StmtKind::while_do:
+				while_statement(*static_cast<const WhileStmt*>(statement));
+				break;
+			case StmtKind::repeat_until:
+				repeat_statement(*static_cast<const RepeatStmt*>(statement));
+				break;
+			case StmtKind::for_do:
+				for_statement(*static_cast<const ForStmt*>(statement));
+				break;
+		}
+	}
+
+	// Each branch knows its condition holds; afterwards only what no
+	// branch changes is known.
+	void Emitter::if_statement(const IfStmt& statement) {
+		const char* prefix { "if (" };
+		for (const auto& branch : statement.branches) {
+			facts_.effects(branch.condition);
+			indent(cxx_);
+			cxx_ += prefix;
+			expression(cxx_, branch.condition);
+			cxx_ += ") {\n";
+			auto before { facts_ };
+			facts_.assume(branch.condition);
+			++level_;
+			statements(branch.body);
+			--level_;
+			facts_ = std::move(before);
+			prefix = "} else if (";
+		}
+		if (statement.has_else) {
+			indent(cxx_);
+			cxx_ += "} else {\n";
+			auto before { facts_ };
+			++level_;
+			statements(statement.otherwise);
+			--level_;
+			facts_ = std::move(before);
+		}
+		indent(cxx_);
+		cxx_ += "}\n";
+		for (const auto& branch : statement.branches) { facts_.enter_loop(branch.body); }
+		facts_.enter_loop(statement.otherwise);
+	}
+
+	// Labels that cover at most 256 values and a quarter of the range
+	// between the smallest and the largest one are listed in a switch on
+	// the selector, which compilers turn into a jump table. Other label
+	// sets are searched in a sorted table for the index of their case.
+	void Emitter::case_statement(const CaseStmt& statement) {
+		struct Interval {
+			std::int64_t low, high;
+			std::size_t index;
+		};
+		std::vector<Interval> intervals;
+		bool characters { false };
+		std::int64_t values { 0 };
+		for (std::size_t i { 0 }; i < statement.cases.size(); ++i) {
+			for (const auto& label : statement.cases[i].labels) {
+				const auto& low { static_cast<const Constant*>(label.low)->value };
+				const auto& high { static_cast<const Constant*>(label.high ? label.high : label.low)->value };
+				characters = low.kind == ValueKind::character;
+				intervals.push_back({ low.integer, high.integer, i });
+				values += high.integer - low.integer + 1;
+			}
+		}
+		std::sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) {
+			return a.low < b.low;
+		});
+		bool dense {
+			intervals.empty() ||
+			(values <= 256 && intervals.back().high - intervals.front().low + 1 <= 4 * values)
+		};
+
+		facts_.effects(statement.selector);
+		indent(cxx_);
+		if (dense) {
+			cxx_ += "switch (";
+			expression(cxx_, statement.selector);
+			cxx_ += ") {\n";
+		} else {
+			auto table { "labels_" + std::to_string(temporaries_++) };
+			cxx_ += "static constexpr SYSTEM_Case_Label ";
+			cxx_ += table;
+			cxx_ += "[] {";
+			const char* separator { " " };
+			for (const auto& interval : intervals) {
+				cxx_ += separator;
+				cxx_ += "{ ";
+				cxx_ += std::to_string(interval.low);
+				cxx_ += ", ";
+				cxx_ += std::to_string(interval.high);
+				cxx_ += ", ";
+				cxx_ += std::to_string(interval.index);
+				cxx_ += " }";
+				separator = ", ";
+			}
+			cxx_ += " };\n";
+			indent(cxx_);
+			cxx_ += "switch (SYSTEM_find_case(";
+			cxx_ += table;
+			cxx_ += ", ";
+			if (characters) { cxx_ += "static_cast<unsigned char>("; }
+			expression(cxx_, statement.selector);
+			if (characters) { cxx_ += ")"; }
+			cxx_ += ")) {\n";
+		}
+
+		auto before { facts_ };
+		++level_;
+		for (std::size_t i { 0 }; i < statement.cases.size(); ++i) {
+			const auto& item { statement.cases[i] };
+			indent(cxx_);
+			if (dense) {
+				// eight labels to a line
+				std::size_t count { 0 };
+				for (const auto& interval : intervals) {
+					if (interval.index != i) { continue; }
+					for (auto value { interval.low }; value <= interval.high; ++value) {
+						if (count && count % 8 == 0) {
+							cxx_ += "\n";
+							indent(cxx_);
+						} else if (count) {
+							cxx_ += " ";
+						}
+						cxx_ += "case ";
+						if (characters) {
+							char_literal(cxx_, value);
+						} else {
+							cxx_ += std::to_string(value);
+						}
+						cxx_ += ":";
+						++count;
+					}
+				}
+			} else {
+				cxx_ += "case ";
+				cxx_ += std::to_string(i);
+				cxx_ += ":";
+			}
+			cxx_ += " {\n";
+			// the selector lies between the smallest and the largest label
+			std::int64_t low { 0 }, high { -1 };
+			for (const auto& interval : intervals) {
+				if (interval.index != i) { continue; }
+				if (low > high) { low = interval.low; }
+				high = interval.high;
+			}
+			facts_.narrow(statement.selector, low, high);
+			++level_;
+			statements(item.body);
+			indent(cxx_);
+			cxx_ += "break;\n";
+			--level_;
+			indent(cxx_);
+			cxx_ += "}\n";
+			facts_ = before;
+		}
+		indent(cxx_);
+		if (statement.has_else) {
+			cxx_ += "default: {\n";
+			++level_;
+			statements(statement.otherwise);
+			--level_;
+			indent(cxx_);
+			cxx_ += "}\n";
+			facts_ = before;
+		} else {
+			cxx_ += "default:\n";
+			indent(cxx_);
+			cxx_ += "\tSYSTEM_trap_case(";
+			source_position(cxx_, statement.pos);
+			cxx_ += ");\n";
+		}
+		--level_;
+		indent(cxx_);
+		cxx_ += "}\n";
+		for (const auto& item : statement.cases) { facts_.enter_loop(item.body); }
+		facts_.enter_loop(statement.otherwise);
+	}
+
+	// The branches test the dynamic type in order, each by one load of
+	// the descriptor at the extension level of its label. In a branch the
+	// variable has the type of its label.
+	// This is a chain, not a switch: descriptors are addresses, which
+	// cannot be case labels, and a record has no small type number, so
+	// dispatch is linear in the number of labels. The first label the
+	// type extends wins, as the report requires.
+	void Emitter::type_case_statement(const CaseStmt& statement) {
+		const auto& variable { static_cast<const Ident*>(statement.selector)->ident };
+		if (!is_pointer(variable_type(statement.selector)) && !record_parameter(statement.selector)) {
+			throw Error { "type CASE needs a pointer or a VAR record parameter" };
+		}
+		auto tag { "tag_" + std::to_string(temporaries_++) };
+		indent(cxx_);
+		cxx_ += "const SYSTEM_Type_Descriptor* ";
+		cxx_ += tag;
+		cxx_ += " { ";
+		type_tag(cxx_, statement.selector);
+		cxx_ += " };\n";
+
+		auto before { facts_ };
+		const char* prefix { "if (" };
+		for (const auto& item : statement.cases) {
+			const auto& label { static_cast<const Ident*>(item.labels[0].low)->ident };
+			indent(cxx_);
+			cxx_ += prefix;
+			cxx_ += "SYSTEM_is(";
+			cxx_ += tag;
+			cxx_ += ", ";
+			record_name(cxx_, label);
+			cxx_ += "_descriptor)) {\n";
+			narrowed_.emplace_back(&variable, &label);
+			++level_;
+			statements(item.body);
+			--level_;
+			narrowed_.pop_back();
+			facts_ = before;
+			prefix = "} else if (";
+		}
+		indent(cxx_);
+		cxx_ += "} else {\n";
+		++level_;
+		if (statement.has_else) {
+			statements(statement.otherwise);
+			facts_ = before;
+		} else {
+			indent(cxx_);
+			cxx_ += "SYSTEM_trap_case(";
+			source_position(cxx_, statement.pos);
+			cxx_ += ");\n";
+		}
+		--level_;
+		indent(cxx_);
+		cxx_ += "}\n";
+		for (const auto& item : statement.cases) { facts_.enter_loop(item.body); }
+		facts_.enter_loop(statement.otherwise);
+	}
+
+	// a WHILE with ELSIF branches loops until no condition holds
+	void Emitter::while_statement(const WhileStmt& statement) {
+		for (const auto& branch : statement.branches) {
+			facts_.enter_loop(branch.body);
+			facts_.effects(branch.condition);
+		}
+		auto invariant { facts_ };
+		auto body = [&](const Branch& branch) {
+			facts_.assume(branch.condition);
+			++level_;
+			statements(branch.body);
+			--level_;
+			facts_ = invariant;
+		};
+		if (statement.branches.size() == 1) {
+			const auto& branch { statement.branches[0] };
+			indent(cxx_);
+			cxx_ += "while (";
+			expression(cxx_, branch.condition);
+			cxx_ += ") {\n";
+			body(branch);
+			indent(cxx_);
+			cxx_ += "}\n";
+			return;
+		}
+		indent(cxx_);
+		cxx_ += "for (;;) {\n";
+		++level_;
+		const char* prefix { "if (" };
+		for (const auto& branch : statement.branches) {
+			indent(cxx_);
+			cxx_ += prefix;
+			expression(cxx_, branch.condition);
+			cxx_ += ") {\n";
+			body(branch);
+			prefix = "} else if (";
+		}
+		indent(cxx_);
+		cxx_ += "} else {\n";
+		indent(cxx_);
+		cxx_ += "\tbreak;\n";
+		indent(cxx_);
+		cxx_ += "}\n";
+		--level_;
+		indent(cxx_);
+		cxx_ += "}\n";
+	}
+
+	void Emitter::repeat_statement(const RepeatStmt& statement) {
+		facts_.enter_loop(statement.body);
+		facts_.effects(statement.condition);
+		indent(cxx_);
+		cxx_ += "do {\n";
+		++level_;
+		statements(statement.body);
+		--level_;
+		facts_.effects(statement.condition);
+		indent(cxx_);
+		cxx_ += "} while (!(";
+		expression(cxx_, statement.condition);
+		cxx_ += "));\n";
+	}
+
+	bool is_predeclared(const Expr* procedure, std::string_view name) {
+		if (procedure->kind != ExprKind::ident) { return false; }
+		const auto& ident { static_cast<const Ident*>(procedure)->ident };
+		return ident.module.empty() && ident.name.text() == name;
+	}
+
+	bool is_variable(const Expr* expr, const Name& name) {
+		while (expr->kind == ExprKind::paren) { expr = static_cast<const Paren*>(expr)->inner; }
+		if (expr->kind != ExprKind::ident) { return false; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		return ident.module.empty() && ident.name == name;
+	}
+
+	bool mentions(const Expr* expr, const Name& name) {
+		if (!expr) { return false; }
+		switch (expr->kind) {
+			case ExprKind::ident: return is_variable(expr, name);
+			case ExprKind::field: return mentions(static_cast<const Field*>(expr)->base, name);
+			case ExprKind::deref: return mentions(static_cast<const Deref*>(expr)->base, name);
+			case ExprKind::paren: return mentions(static_cast<const Paren*>(expr)->inner, name);
+			case ExprKind::unary: return mentions(static_cast<const Unary*>(expr)->operand, name);
+			case ExprKind::set:
+				for (const auto& element : static_cast<const SetExpr*>(expr)->elements) {
+					if (mentions(element.low, name) || mentions(element.high, name)) { return true; }
+				}
+				return false;
+			case ExprKind::binary: {
+				const auto& binary { *static_cast<const Binary*>(expr) };
+				return mentions(binary.left, name) || mentions(binary.right, name);
+			}
+			case ExprKind::index: {
+				const auto& index { *static_cast<const Index*>(expr) };
+				if (mentions(index.base, name)) { return true; }
+				for (const auto* item : index.indices) {
+					if (mentions(item, name)) { return true; }
+				}
+				return false;
+			}
+			case ExprKind::call: {
+				const auto& call { *static_cast<const Call*>(expr) };
+				if (mentions(call.procedure, name)) { return true; }
+				for (const auto* argument : call.arguments) {
+					if (mentions(argument, name)) { return true; }
+				}
+				return false;
+			}
+			default: return false;
+		}
+	}
+
+	// The limit is evaluated once into a local, unless it depends on the
+	// control variable or evaluating it before the start value changes
+	// the results. So the loop has the counted form compilers vectorize.
+	// In the body the control variable lies between the start value and
+	// the limit.
+	void Emitter::for_statement(const ForStmt& statement) {
+		auto step { static_cast<const Constant*>(statement.step)->value.integer };
+		auto control { statement.control.text() };
+		facts_.effects(statement.begin);
+		auto first { facts_.range(statement.begin) };
+		bool hoisted {
+			statement.end->kind != ExprKind::constant &&
+			!mentions(statement.end, statement.control) && !calls(statement.begin) &&
+			(statement.begin->kind == ExprKind::constant || !calls(statement.end))
+		};
+		std::string limit_name;
+		Range limit;
+		if (hoisted) {
+			facts_.effects(statement.end);
+			limit = facts_.range(statement.end);
+			limit_name = "limit_" + std::to_string(temporaries_++);
+			indent(cxx_);
+			cxx_ += "const SYSTEM_INTEGER ";
+			cxx_ += limit_name;
+			cxx_ += " { ";
+			expression(cxx_, statement.end);
+			cxx_ += " };\n";
+		}
+		auto loop_start { cxx_.size() };
+		auto checks_before { emitted_checks_ };
+		indent(cxx_);
+		cxx_ += "for (";
+		name(cxx_, statement.control);
+		cxx_ += " = ";
+		expression(cxx_, statement.begin);
+		cxx_ += "; ";
+		facts_.set(control, { });
+		bool unchanged { facts_.enter_loop(statement.body, control) };
+		if (!hoisted) {
+			facts_.effects(statement.end);
+			limit = facts_.range(statement.end);
+		}
+		auto invariant { facts_ };
+		name(cxx_, statement.control);
+		cxx_ += step > 0 ? " <= " : " >= ";
+		if (hoisted) {
+			cxx_ += limit_name;
+		} else {
+			expression(cxx_, statement.end);
+		}
+		cxx_ += "; ";
+		if (step == 1 || step == -1) {
+			cxx_ += step > 0 ? "++" : "--";
+			name(cxx_, statement.control);
+		} else {
+			name(cxx_, statement.control);
+			cxx_ += step > 0 ? " += " : " -= ";
+			cxx_ += std::to_string(step > 0 ? step : -step);
+		}
+		cxx_ += ") {\n";
+		if (unchanged) {
+			Range values;
+			const auto& low { step > 0 ? first : limit };
+			const auto& high { step > 0 ? limit : first };
+			values.has_lower = low.has_lower;
+			values.lower = low.lower;
+			values.has_upper = high.has_upper;
+			values.upper = high.upper;
+			values.length_of = high.length_of;
+			values.length_offset = high.length_offset;
+			facts_.set(control, values);
+		}
+		++level_;
+		statements(statement.body);
+		--level_;
+		facts_ = std::move(invariant);
+		facts_.forget(control);
+		indent(cxx_);
+		cxx_ += "}\n";
+		// a trapping index check keeps the loop from being vectorized, and
+		// the pragma needs a trip count that is known before the loop,
+		// from bounds without effects
+		bool counted {
+			(hoisted || statement.end->kind == ExprKind::constant) &&
+			!calls(statement.begin) && !calls(statement.end)
+		};
+		if (simd_ && counted && emitted_checks_ == checks_before && independent_iterations(statement)) {
+			std::string pragma;
+			indent(pragma);
+			pragma += "#pragma omp simd\n";
+			cxx_.insert(loop_start, pragma);
+		}
+	}
+
+	// True if the iterations of a loop can run in any order: the body
+	// only assigns array elements indexed by the control variable, and
+	// every other access to an array that may be assigned uses the same
+	// index. Parameters may alias each other and global arrays.
+	bool Emitter::independent_iterations(const ForStmt& statement) const {
+		if (statement.body.empty()) { return false; }
+		auto is_parameter = [&](const Name& name) {
+			if (procedures_.empty()) { return false; }
+			for (const auto& section : procedures_.back()->signature->sections) {
+				for (const auto& ident : section.names) {
+					if (ident.name == name) { return true; }
+				}
+			}
+			return false;
+		};
+		// unqualified array variable with one index, or nullptr
+		auto element_of = [&](const Expr* expr) -> const Ident* {
+			if (expr->kind != ExprKind::index) { return nullptr; }
+			const auto& index { *static_cast<const Index*>(expr) };
+			if (index.base->kind != ExprKind::ident || index.indices.size() != 1) { return nullptr; }
+			const auto* base { static_cast<const Ident*>(index.base) };
+			return base->ident.module.empty() ? base : nullptr;
+		};
+
+		std::set<std::string_view> assigned;
+		bool assigns_parameter { false };
+		for (const auto* item : statement.body) {
+			if (item->kind != StmtKind::assignment) { return false; }
+			const auto& assignment { *static_cast<const Assignment*>(item) };
+			auto target { element_of(assignment.target) };
+			if (!target ||
+				!is_variable(static_cast<const Index*>(assignment.target)->indices[0], statement.control)
+			) {
+				return false;
+			}
+			// whole rows are not elements
+			std::uint32_t rank { 0 };
+			if (auto type { resolve(variable_type(target)) }) { array_element(type, rank); }
+			if (rank != 1) { return false; }
+			assigned.insert(target->ident.name.text());
+			assigns_parameter = assigns_parameter || is_parameter(target->ident.name);
+		}
+
+		bool independent { true };
+		std::function<void(const Expr*)> check = [&](const Expr* expr) {
+			switch (expr->kind) {
+				case ExprKind::index: {
+					const auto& index { *static_cast<const Index*>(expr) };
+					for (const auto* item : index.indices) { check(item); }
+					// other designators may share elements with an
+					// assigned array
+					auto base { element_of(expr) };
+					if (!base) {
+						independent = false;
+						return;
+					}
+					const auto& name { base->ident.name };
+					bool may_alias {
+						assigned.count(name.text()) || assigns_parameter || is_parameter(name)
+					};
+					if (may_alias && !is_variable(index.indices[0], statement.control)) {
+						independent = false;
+					}
+					break;
+				}
+				case ExprKind::field: check(static_cast<const Field*>(expr)->base); break;
+				case ExprKind::deref: check(static_cast<const Deref*>(expr)->base); break;
+				case ExprKind::call: {
+					// only predeclared functions, they have no effects
+					const auto& call { *static_cast<const Call*>(expr) };
+					bool pure { false };
+					for (auto name : { "ABS", "ODD", "ORD", "CHR", "FLT", "FLOOR", "LEN" }) {
+						pure = pure || is_predeclared(call.procedure, name);
+					}
+					if (!pure || procedure_signature(call.procedure) || variable_type(call.procedure)) {
+						independent = false;
+						break;
+					}
+					for (const auto* argument : call.arguments) { check(argument); }
+					break;
+				}
+				case ExprKind::paren: check(static_cast<const Paren*>(expr)->inner); break;
+				case ExprKind::unary: check(static_cast<const Unary*>(expr)->operand); break;
+				case ExprKind::binary:
+					check(static_cast<const Binary*>(expr)->left);
+					check(static_cast<const Binary*>(expr)->right);
+					break;
+				case ExprKind::ident: {
+					// assigned arrays are only accessed element by element
+					const auto& ident { static_cast<const Ident*>(expr)->ident };
+					if (ident.module.empty() && assigned.count(ident.name.text())) { independent = false; }
+					break;
+				}
+				default:
+					break;
+			}
+		};
+		for (const auto* item : statement.body) {
+			const auto& assignment { *static_cast<const Assignment*>(item) };
+			check(assignment.target);
+			check(assignment.value);
+		}
+		return independent;
+	}
+
+	void Emitter::expression(std::string& out, const Expr* expr, bool as_char) {
+		switch (expr->kind) {
+			case ExprKind::integer: case ExprKind::real:
+			case ExprKind::string: case ExprKind::character:
+				literal(out, *static_cast<const Literal*>(expr));
+				break;
+			case ExprKind::nil:
+				out += "nullptr";
+				break;
+			case ExprKind::boolean:
+				out += static_cast<const BooleanLiteral*>(expr)->value ? "true" : "false";
+				break;
+			case ExprKind::ident: {
+				const auto& ident { static_cast<const Ident*>(expr)->ident };
+				if (auto label { narrowed(ident) }) {
+					out += "static_cast<";
+					record_name(out, *label);
+					out += record_parameter(expr) ? "&>(" : "*>(";
+					qual_ident(out, ident);
+					out += ")";
+				} else {
+					qual_ident(out, ident);
+				}
+				break;
+			}
+			case ExprKind::field: {
+				const auto& field { *static_cast<const Field*>(expr) };
+				out += "(";
+				expression(out, field.base);
+				out += is_pointer(declared_type(field.base)) ? ")->" : ").";
+				out += field.field.text();
+				break;
+			}
+			case ExprKind::index:
+				index(out, *static_cast<const Index*>(expr));
+				break;
+			case ExprKind::deref:
+				out += "*(";
+				expression(out, static_cast<const Deref*>(expr)->base);
+				out += ")";
+				break;
+			case ExprKind::call:
+				call(out, *static_cast<const Call*>(expr));
+				break;
+			case ExprKind::unary: {
+				const auto& unary { *static_cast<const Unary*>(expr) };
+				if (unary.op == Token_notop) {
+					out += "!(";
+					expression(out, unary.operand);
+					out += ")";
+				} else if (unary.op == Token_minus && is_set(unary.operand)) {
+					out += "~(";
+					expression(out, unary.operand);
+					out += ")";
+				} else {
+					out += unary.op == Token_minus ? "-" : "+";
+					expression(out, unary.operand);
+				}
+				break;
+			}
+			case ExprKind::binary:
+				binary(out, *static_cast<const Binary*>(expr));
+				break;
+			case ExprKind::paren:
+				out += "(";
+				expression(out, static_cast<const Paren*>(expr)->inner, as_char);
+				out += ")";
+				break;
+			case ExprKind::constant:
+				constant(out, static_cast<const Constant*>(expr)->value, as_char);
+				break;
+			case ExprKind::set: {
+				// single elements and ranges are or-ed together
+				const auto& set { *static_cast<const SetExpr*>(expr) };
+				if (set.elements.empty()) {
+					out += "SYSTEM_SET { 0 }";
+					break;
+				}
+				out += "(";
+				const char* separator { "" };
+				for (const auto& element : set.elements) {
+					out += separator;
+					out += element.high ? "SYSTEM_set_range(" : "SYSTEM_set_element(";
+					expression(out, element.low);
+					if (element.high) {
+						out += ", ";
+						expression(out, element.high);
+					}
+					set_check(out, { element.low, element.high });
+					out += ")";
+					separator = " | ";
+				}
+				out += ")";
+				break;
+			}
+		}
+	}
+
+	void Emitter::literal(std::string& out, const Literal& literal) {
+		switch (literal.kind) {
+			case ExprKind::integer:
+				if (literal.text.back() == 'H') {
+					out += "0x";
+					out += literal.text.substr(0, literal.text.size() - 1);
+				} else {
+					out += literal.text;
+				}
+				break;
+			case ExprKind::string:
+				out += "Oberon_String { ";
+				string_literal(out, literal.text);
+				out += ", ";
+				out += std::to_string(literal.text.size());
+				out += " }";
+				break;
+			case ExprKind::character:
+				out += "'\\x";
+				out += literal.text;
+				out += "'";
+				break;
+			default:
+				out += literal.text;
+		}
+	}
+
+	// one character strings are CHAR constants where a CHAR is expected
+	void Emitter::constant(std::string& out, const Value& value, bool as_char) {
+		char buffer[32];
+		switch (value.kind) {
+			case ValueKind::integer:
+				// -2147483648 would be the negated long 2147483648
+				if (value.integer == INT32_MIN) {
+					out += "(-2147483647 - 1)";
+				} else {
+					out += std::to_string(value.integer);
+				}
+				break;
+			case ValueKind::real: {
+				// shortest text that reads back as the same double
+				auto end { std::to_chars(buffer, buffer + sizeof(buffer), value.real).ptr };
+				std::string_view text { buffer, static_cast<std::size_t>(end - buffer) };
+				out += text;
+				if (text.find_first_of(".en") == std::string_view::npos) { out += ".0"; }
+				break;
+			}
+			case ValueKind::boolean:
+				out += value.integer ? "true" : "false";
+				break;
+			case ValueKind::character:
+				char_literal(out, value.integer);
+				break;
+			case ValueKind::set: {
+				auto end { std::to_chars(
+					buffer, buffer + sizeof(buffer), static_cast<std::uint64_t>(value.integer), 16
+				).ptr };
+				out += "SYSTEM_SET { 0x";
+				out.append(buffer, end);
+				out += "u }";
+				break;
+			}
+			case ValueKind::string: {
+				if (as_char && value.string.size() == 1) {
+					char_literal(out, static_cast<unsigned char>(value.string[0]));
+					break;
+				}
+				auto got { string_ids_.emplace(value.string, strings_.size()) };
+				if (got.second) { strings_.push_back(value.string); }
+				out += module_.name.text();
+				out += "_string_";
+				out += std::to_string(got.first->second);
+				break;
+			}
+		}
+	}
+
+	// constant lengths of the dimensions of an array type, -1 for open ones
+	void array_lengths(const Type* type, std::vector<std::int64_t>& lengths) {
+		for (;;) {
+			if (type->kind == TypeKind::open_array) {
+				lengths.push_back(-1);
+				type = static_cast<const OpenArrayType*>(type)->element;
+			} else if (type->kind == TypeKind::array) {
+				const auto& array { *static_cast<const ArrayType*>(type) };
+				for (const auto* length : array.lengths) {
+					lengths.push_back(length->kind == ExprKind::constant ?
+						static_cast<const Constant*>(length)->value.integer : -1);
+				}
+				type = array.element;
+			} else {
+				return;
+			}
+		}
+	}
+
+	// All indices of one array go into one access, so its element offset
+	// is computed at once; an element that is an array itself is indexed
+	// by the following ones. Checked accesses trap with the position of
+	// their first index. Accesses whose indices are known to be in range
+	// are not checked.
+	void Emitter::index(std::string& out, const Index& index) {
+		std::vector<const Expr*> indices;
+		auto base { index_chain(index, indices) };
+		out += "(";
+		expression(out, base);
+		out += ")";
+		auto type { expression_type(base) };
+		std::size_t next { 0 };
+		while (next < indices.size()) {
+			std::uint32_t rank { 0 };
+			auto element { type ? array_element(type, rank) : nullptr };
+			auto count { rank ? std::min<std::size_t>(rank, indices.size() - next) : indices.size() - next };
+			bool proven { rank != 0 };
+			if (checked_ && proven) {
+				std::vector<std::int64_t> lengths;
+				array_lengths(type, lengths);
+				for (std::size_t i { 0 }; i < count && proven; ++i) {
+					// LEN(a) is the length of the first dimension of a
+					auto array { next == 0 && i == 0 ? base : nullptr };
+					proven = facts_.in_bounds(indices[next + i], array, lengths[i]);
+				}
+			}
+			if (checked_ && !proven) { ++emitted_checks_; }
+			if (checked_ && !proven && checks_) {
+				source_position(*checks_, indices[next]->pos, false);
+				*checks_ += ": index check in ";
+				*checks_ += procedures_.empty() ? "module body" :
+					std::string { procedures_.back()->ident.name.text() };
+				*checks_ += "\n";
+			}
+			if (checked_ && !proven) {
+				out += ".at(";
+				source_position(out, indices[next]->pos);
+				for (std::size_t i { next }; i < next + count; ++i) {
+					out += ", ";
+					expression(out, indices[i]);
+				}
+				out += ")";
+			} else {
+				out += count == 1 ? "[" : "(";
+				for (std::size_t i { next }; i < next + count; ++i) {
+					if (i != next) { out += ", "; }
+					expression(out, indices[i]);
+				}
+				out += count == 1 ? "]" : ")";
+			}
+			next += count;
+			type = count == rank ? resolve(element) : nullptr;
+		}
+	}
+
+	// Checked set elements pass the position of the first one, so
+	// elements outside 0 .. 63 trap; elements known to be in range are
+	// not checked.
+	void Emitter::set_check(std::string& out, std::initializer_list<const Expr*> elements) {
+		if (!checked_) { return; }
+		bool proven { true };
+		for (const auto* element : elements) {
+			if (!element) { continue; }
+			auto range { facts_.range(element) };
+			proven = proven && range.has_lower && range.lower >= 0 && range.has_upper && range.upper < 64;
+		}
+		if (proven) { return; }
+		++emitted_checks_;
+		auto pos { (*elements.begin())->pos };
+		if (checks_) {
+			source_position(*checks_, pos, false);
+			*checks_ += ": set element check in ";
+			*checks_ += procedures_.empty() ? "module body" :
+				std::string { procedures_.back()->ident.name.text() };
+			*checks_ += "\n";
+		}
+		out += ", ";
+		source_position(out, pos);
+	}
+
+	void Emitter::call(std::string& out, const Call& call) {
+		if (is_predeclared(call.procedure, "LEN") && !procedure_signature(call.procedure) &&
+			call.arguments.size() == 1
+		) {
+			out += "(";
+			expression(out, call.arguments[0]);
+			out += ").lengths[0]";
+			return;
+		}
+		for (auto name : { "INCL", "EXCL" }) {
+			if (is_predeclared(call.procedure, name) && !procedure_signature(call.procedure) &&
+				call.arguments.size() == 2
+			) {
+				out += "SYSTEM_";
+				out += name;
+				out += "(";
+				expression(out, call.arguments[0]);
+				out += ", ";
+				expression(out, call.arguments[1]);
+				set_check(out, { call.arguments[1] });
+				out += ")";
+				return;
+			}
+		}
+		if (is_predeclared(call.procedure, "NEW") && !procedure_signature(call.procedure) &&
+			call.arguments.size() == 1
+		) {
+			out += "SYSTEM_NEW(";
+			expression(out, call.arguments[0]);
+			out += ", ";
+			pointer_record(out, declared_type(call.arguments[0]));
+			out += "_descriptor)";
+			return;
+		}
+		if (is_guard(call)) {
+			// pointers carry their tag in the block header
+			const auto& type { static_cast<const Ident*>(call.arguments[0])->ident };
+			out += "SYSTEM_guard<";
+			record_name(out, type);
+			out += ">(";
+			expression(out, call.procedure);
+			out += ", ";
+			if (!is_pointer(declared_type(call.procedure))) {
+				type_tag(out, call.procedure);
+				out += ", ";
+			}
+			record_name(out, type);
+			out += "_descriptor, ";
+			source_position(out, call.pos);
+			out += ")";
+			return;
+		}
+		expression(out, call.procedure);
+		out += "(";
+		auto signature { procedure_signature(call.procedure) };
+		std::vector<const ParameterSection*> parameters;
+		if (signature) {
+			for (const auto& section : signature->sections) {
+				for (std::uint32_t i { 0 }; i < section.names.size(); ++i) {
+					parameters.push_back(&section);
+				}
+			}
+		}
+		const char* separator { "" };
+		for (std::uint32_t i { 0 }; i < call.arguments.size(); ++i) {
+			out += separator;
+			auto parameter { i < parameters.size() ? parameters[i] : nullptr };
+			expression(out, call.arguments[i], parameter && is_char_type(parameter->type));
+			if (parameter && parameter->reference && is_record(parameter->type)) {
+				out += ", ";
+				type_tag(out, call.arguments[i]);
+			}
+			separator = ", ";
+		}
+		out += ")";
+	}
+
+	// x(T) of a record or pointer variable x is a type guard, not a call
+	bool Emitter::is_guard(const Call& call) const {
+		if (call.arguments.size() != 1 || call.arguments[0]->kind != ExprKind::ident ||
+			procedure_signature(call.procedure)
+		) {
+			return false;
+		}
+		auto type { declared_type(call.procedure) };
+		return is_record(type) || is_pointer(type);
+	}
+
+	// a VAR parameter of record type, which has a type tag
+	bool Emitter::record_parameter(const Expr* expr) const {
+		if (expr->kind != ExprKind::ident) { return false; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		if (!ident.module.empty()) { return false; }
+		for (auto it { procedures_.rbegin() }; it != procedures_.rend(); ++it) {
+			for (const auto& section : (*it)->signature->sections) {
+				for (const auto& name : section.names) {
+					if (name.name == ident.name) { return section.reference && is_record(section.type); }
+				}
+			}
+			for (const auto* decl : (*it)->declarations.vars) {
+				for (const auto& name : decl->names) {
+					if (name.name == ident.name) { return false; }
+				}
+			}
+		}
+		return false;
+	}
+
+	// descriptor of the dynamic type of a record designator or of the
+	// records a pointer points to: the tag of a VAR parameter or heap
+	// block, else the descriptor of its declared type
+	void Emitter::type_tag(std::string& out, const Expr* expr) {
+		while (expr->kind == ExprKind::paren) { expr = static_cast<const Paren*>(expr)->inner; }
+		if (expr->kind == ExprKind::call && is_guard(*static_cast<const Call*>(expr))) {
+			type_tag(out, static_cast<const Call*>(expr)->procedure);
+			return;
+		}
+		if (expr->kind == ExprKind::deref || is_pointer(declared_type(expr))) {
+			out += "SYSTEM_tag(";
+			expression(out, expr->kind == ExprKind::deref ? static_cast<const Deref*>(expr)->base : expr);
+			out += ")";
+			return;
+		}
+		if (record_parameter(expr)) {
+			name(out, static_cast<const Ident*>(expr)->ident.name);
+			out += "_tag";
+			return;
+		}
+		auto type { declared_type(expr) };
+		if (!type || type->kind != TypeKind::named) { throw Error { "record type of designator unknown" }; }
+		out += "&";
+		qual_ident(out, static_cast<const NamedType*>(type)->ident);
+		out += "_descriptor";
+	}
+
+	const Expr* without_parens(const Expr* expr) {
+		while (expr->kind == ExprKind::paren) { expr = static_cast<const Paren*>(expr)->inner; }
+		return expr;
+	}
+
+	// both expressions have the same value, if they have no side effects
+	bool same_value(const Expr* a, const Expr* b) {
+		a = without_parens(a);
+		b = without_parens(b);
+		if (a->kind != b->kind) { return false; }
+		switch (a->kind) {
+			case ExprKind::ident: {
+				const auto& x { static_cast<const Ident*>(a)->ident };
+				const auto& y { static_cast<const Ident*>(b)->ident };
+				return x.module == y.module && x.name == y.name;
+			}
+			case ExprKind::field: {
+				const auto& x { *static_cast<const Field*>(a) };
+				const auto& y { *static_cast<const Field*>(b) };
+				return x.field == y.field && same_value(x.base, y.base);
+			}
+			case ExprKind::index: {
+				const auto& x { *static_cast<const Index*>(a) };
+				const auto& y { *static_cast<const Index*>(b) };
+				if (x.indices.size() != y.indices.size() || !same_value(x.base, y.base)) { return false; }
+				for (std::uint32_t i { 0 }; i < x.indices.size(); ++i) {
+					if (!same_value(x.indices[i], y.indices[i])) { return false; }
+				}
+				return true;
+			}
+			case ExprKind::deref:
+				return same_value(static_cast<const Deref*>(a)->base, static_cast<const Deref*>(b)->base);
+			case ExprKind::constant: {
+				const auto& x { static_cast<const Constant*>(a)->value };
+				const auto& y { static_cast<const Constant*>(b)->value };
+				return x.kind == y.kind && x.integer == y.integer && x.string == y.string;
+			}
+			default:
+				return false;
+		}
+	}
+
+	// integer or character constant; one character strings are characters
+	bool test_constant(const Expr* expr, std::int64_t& value, bool& character) {
+		expr = without_parens(expr);
+		if (expr->kind != ExprKind::constant) { return false; }
+		const auto& constant { static_cast<const Constant*>(expr)->value };
+		character = constant.kind != ValueKind::integer;
+		if (constant.kind == ValueKind::integer || constant.kind == ValueKind::character) {
+			value = constant.integer;
+			return true;
+		}
+		if (constant.kind == ValueKind::string && constant.string.size() == 1) {
+			value = static_cast<unsigned char>(constant.string[0]);
+			return true;
+		}
+		return false;
+	}
+
+	// operand = c, or operand compared to constants on both sides like
+	// (operand >= low) & (operand <= high)
+	struct ValueTest {
+		const Expr* operand { nullptr };
+		bool has_low { false };
+		std::int64_t low { 0 };
+		bool has_high { false };
+		std::int64_t high { 0 };
+		bool characters { false };
+	};
+
+	bool value_test(const Expr* expr, ValueTest& test) {
+		expr = without_parens(expr);
+		if (expr->kind != ExprKind::binary) { return false; }
+		const auto& binary { *static_cast<const Binary*>(expr) };
+		if (binary.op == Token_andop) {
+			ValueTest right;
+			if (!value_test(binary.left, test) || !value_test(binary.right, right) ||
+				test.characters != right.characters || !same_value(test.operand, right.operand)
+			) {
+				return false;
+			}
+			if (right.has_low) {
+				test.low = test.has_low ? std::max(test.low, right.low) : right.low;
+				test.has_low = true;
+			}
+			if (right.has_high) {
+				test.high = test.has_high ? std::min(test.high, right.high) : right.high;
+				test.has_high = true;
+			}
+			return true;
+		}
+		std::int64_t value;
+		auto op { binary.op };
+		if (test_constant(binary.right, value, test.characters)) {
+			test.operand = binary.left;
+		} else if (test_constant(binary.left, value, test.characters)) {
+			test.operand = binary.right;
+			// c < x is x > c
+			switch (op) {
+				case Token_less: op = Token_greater; break;
+				case Token_lessOrEqual: op = Token_greaterOrEqual; break;
+				case Token_greater: op = Token_less; break;
+				case Token_greaterOrEqual: op = Token_lessOrEqual; break;
+				default: break;
+			}
+		} else {
+			return false;
+		}
+		if (calls(test.operand)) { return false; }
+		switch (op) {
+			case Token_equals:
+				test.has_low = test.has_high = true;
+				test.low = test.high = value;
+				return true;
+			case Token_less: test.has_high = true; test.high = value - 1; return true;
+			case Token_lessOrEqual: test.has_high = true; test.high = value; return true;
+			case Token_greater: test.has_low = true; test.low = value + 1; return true;
+			case Token_greaterOrEqual: test.has_low = true; test.low = value; return true;
+			default: return false;
+		}
+	}
+
+	// Tests of one operand against constants joined by OR, and a closed
+	// range test with &, become one unsigned compare or, if the values
+	// lie within 64 of each other, one bit mask test. The operand is
+	// evaluated once instead of for every comparison.
+	bool Emitter::membership(std::string& out, const Binary& binary) {
+		std::vector<const Expr*> terms;
+		std::vector<const Expr*> pending { &binary };
+		while (!pending.empty()) {
+			auto term { without_parens(pending.back()) };
+			pending.pop_back();
+			if (binary.op == Token_kwOR && term->kind == ExprKind::binary &&
+				static_cast<const Binary*>(term)->op == Token_kwOR
+			) {
+				pending.push_back(static_cast<const Binary*>(term)->left);
+				pending.push_back(static_cast<const Binary*>(term)->right);
+			} else {
+				terms.push_back(term);
+			}
+		}
+
+		struct Interval {
+			std::int64_t low, high;
+		};
+		std::vector<Interval> intervals;
+		ValueTest first;
+		for (const auto* term : terms) {
+			ValueTest test;
+			if (!value_test(term, test) || !test.has_low || !test.has_high || test.low > test.high) {
+				return false;
+			}
+			if (!first.operand) {
+				first = test;
+			} else if (test.characters != first.characters || !same_value(test.operand, first.operand)) {
+				return false;
+			}
+			intervals.push_back({ test.low, test.high });
+		}
+		std::sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) {
+			return a.low < b.low;
+		});
+		std::vector<Interval> merged;
+		for (const auto& interval : intervals) {
+			if (!merged.empty() && interval.low <= merged.back().high + 1) {
+				merged.back().high = std::max(merged.back().high, interval.high);
+			} else {
+				merged.push_back(interval);
+			}
+		}
+		bool range { merged.size() == 1 && merged[0].low != merged[0].high };
+		bool mask { merged.size() > 1 && merged.back().high - merged.front().low < 64 };
+		if (!range && !mask) { return false; }
+
+		auto value = [&](std::int64_t v) {
+			if (first.characters && v < 0x80) {
+				char_literal(out, v);
+			} else {
+				out += std::to_string(v);
+			}
+		};
+		out += range ? "SYSTEM_in_range(" : "SYSTEM_in_mask(";
+		if (first.characters) { out += "static_cast<unsigned char>("; }
+		expression(out, first.operand);
+		if (first.characters) { out += ")"; }
+		out += ", ";
+		value(merged.front().low);
+		out += ", ";
+		if (range) {
+			value(merged.front().high);
+		} else {
+			std::uint64_t bits { 0 };
+			for (const auto& interval : merged) {
+				for (auto v { interval.low }; v <= interval.high; ++v) {
+					bits |= std::uint64_t { 1 } << (v - merged.front().low);
+				}
+			}
+			static constexpr char digits[] { "0123456789ABCDEF" };
+			std::string hex;
+			do {
+				hex.insert(hex.begin(), digits[bits & 0xf]);
+				bits >>= 4;
+			} while (bits);
+			out += "0x";
+			out += hex;
+			out += "ull";
+		}
+		out += ")";
+		return true;
+	}
+
+	void Emitter::binary(std::string& out, const Binary& binary) {
+		if ((binary.op == Token_kwOR || binary.op == Token_andop) && membership(out, binary)) {
+			return;
+		}
+		if (binary.op == Token_kwIS) {
+			out += "SYSTEM_is(";
+			type_tag(out, binary.left);
+			out += ", ";
+			record_name(out, static_cast<const Ident*>(binary.right)->ident);
+			out += "_descriptor)";
+			return;
+		}
+		if (binary.op == Token_kwIN) {
+			out += "SYSTEM_IN(";
+			expression(out, binary.left);
+			out += ", ";
+			expression(out, binary.right);
+			out += ")";
+			return;
+		}
+		if (is_set(binary.left) || is_set(binary.right)) {
+			set_binary(out, binary);
+			return;
+		}
+		bool comparison {
+			binary.op == Token_equals || binary.op == Token_notEquals ||
+			binary.op == Token_less || binary.op == Token_lessOrEqual ||
+			binary.op == Token_greater || binary.op == Token_greaterOrEqual
+		};
+		// strings in character arrays compare up to their 0X
+		bool strings {
+			comparison && (is_char_array(binary.left) || is_char_array(binary.right)) &&
+			!is_char(binary.left) && !is_char(binary.right)
+		};
+		if (strings) {
+			out += "SYSTEM_compare_strings(";
+			expression(out, binary.left);
+			out += ", ";
+			expression(out, binary.right);
+			out += ")";
+		}
+		const char* op;
+		switch (binary.op) {
+			case Token_slash:
+				out += "static_cast<double>(";
+				expression(out, binary.left);
+				out += ") / ";
+				expression(out, binary.right);
+				return;
+			case Token_kwDIV: case Token_kwMOD:
+				out += binary.op == Token_kwDIV ? "SYSTEM_DIV(" : "SYSTEM_MOD(";
+				expression(out, binary.left);
+				out += ", ";
+				expression(out, binary.right);
+				out += ")";
+				return;
+			case Token_equals: op = " == "; break;
+			case Token_notEquals: op = " != "; break;
+			case Token_less: op = " < "; break;
+			case Token_lessOrEqual: op = " <= "; break;
+			case Token_greater: op = " > "; break;
+			case Token_greaterOrEqual: op = " >= "; break;
+			case Token_plus: op = " + "; break;
+			case Token_minus: op = " - "; break;
+			case Token_kwOR: op = " || "; break;
+			case Token_star: op = " * "; break;
+			case Token_andop: op = " && "; break;
+			default: throw Error { "unknown operator" };
+		}
+		if (strings) {
+			out += op;
+			out += "0";
+			return;
+		}
+		auto operand = [&](const Expr* expr, bool as_char) {
+			// & binds tighter than OR in both languages, but compilers
+			// warn about it
+			bool wrap {
+				binary.op == Token_kwOR && expr->kind == ExprKind::binary &&
+				static_cast<const Binary*>(expr)->op == Token_andop
+			};
+			if (wrap) { out += "("; }
+			expression(out, expr, as_char);
+			if (wrap) { out += ")"; }
+		};
+		operand(binary.left, comparison && is_char(binary.right));
+		out += op;
+		if (binary.op == Token_andop) {
+			// the right operand is only evaluated if the left one holds
+			auto before { facts_ };
+			facts_.assume(binary.left);
+			operand(binary.right, false);
+			facts_ = std::move(before);
+			return;
+		}
+		operand(binary.right, comparison && is_char(binary.left));
+	}
+
+	// Set operators are bit operators. Their precedence differs from
+	// that of the Oberon operators, so operands that are operations
+	// themselves are put into parentheses.
+	void Emitter::set_binary(std::string& out, const Binary& binary) {
+		const char* op;
+		switch (binary.op) {
+			case Token_plus: op = " | "; break;
+			case Token_minus: op = " & ~"; break;
+			case Token_star: op = " & "; break;
+			case Token_slash: op = " ^ "; break;
+			case Token_equals: op = " == "; break;
+			case Token_notEquals: op = " != "; break;
+			default: throw Error { "unknown set operator" };
+		}
+		auto operand = [&](const Expr* expr) {
+			bool wrap { expr->kind == ExprKind::binary || expr->kind == ExprKind::unary };
+			if (wrap) { out += "("; }
+			expression(out, expr);
+			if (wrap) { out += ")"; }
+		};
+		operand(binary.left);
+		out += op;
+		operand(binary.right);
+	}
+}
+
+void emit_module(
+	const Module& module, const std::vector<const ModuleInterface*>& imports,
+	std::string& h, std::string& cxx, const EmitOptions& options,
+	const std::set<std::string>* keep
+) {
+	Emitter { module, imports, h, cxx, options, keep }.module();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+
+struct ModuleInterface;
+
+// Linked modules are initialized by a generated oberon_init_all() in
+// import order, so their initializer neither guards against running
+// twice nor initializes the imports; modules without body statements
+// have no initializer. Unity modules are linked modules that become
+// part of a single translation unit, so their code has no includes.
+enum class EmitMode { modular, linked, unity };
+
+struct EmitOptions {
+	EmitMode mode { EmitMode::modular };
+	// array indices are checked and trap with the Oberon source position
+	bool checked { true };
+	// if set, gets a line "Module.Mod:line:column: index check in Proc"
+	// for each check that range analysis cannot prove redundant
+	std::string* checks { nullptr };
+	// FOR loops whose iterations are independent get #pragma omp simd,
+	// which takes effect with -fopenmp-simd
+	bool simd { false };
+};
+
+// Generates the C++ header and body of a parsed module. imports holds
+// the interfaces of module.imports, nullptr where unknown. Unless keep
+// is nullptr, global types, variables and procedures whose qualified
+// name is not in keep are left out; see reachable().
+void emit_module(
+	const Module& module, const std::vector<const ModuleInterface*>& imports,
+	std::string& h, std::string& cxx, const EmitOptions& options,
+	const std::set<std::string>* keep
+);
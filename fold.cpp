@@ -0,0 +1,748 @@
+#include "fold.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Token.h"
+#include "interface.h"
+
+namespace {
+	using Error = std::runtime_error;
+
+	struct Scope {
+		const Scope* outer;
+		const Declarations* declarations;
+		const Signature* signature;
+	};
+
+	class Folder {
+		private:
+			Module& module_;
+			std::vector<const ModuleInterface*> imports_;
+			const Scope* scope_ { nullptr };
+
+		public:
+			Folder(Module& module, Interfaces& interfaces, const std::string& dir);
+
+			void module();
+
+		private:
+			Statements statements(const Statements& statements);
+			bool lookup(const Name& name, const ConstDecl*& constant, const TypeDecl** type = nullptr) const;
+			bool is_type(const Expr* expr) const;
+			bool imported(const QualIdent& ident, Value& value) const;
+
+			void declarations(Declarations& declarations);
+			void procedure(ProcDecl& procedure);
+			void signature(Signature* signature);
+			void type(Type* type);
+			void statement(Stmt* statement, std::vector<Stmt*>& result);
+			bool fold_branches(Span<Branch>& branches, bool stop_at_true);
+			Expr* case_label(Expr* label);
+			void case_statement(CaseStmt& statement, std::vector<Stmt*>& result);
+
+			Expr* expression(Expr* expr);
+			Expr* ident(Ident* ident);
+			Expr* call(Call* call);
+			Expr* unary(Unary* unary);
+			Expr* binary(Binary* binary);
+			Expr* set(SetExpr* set);
+			Expr* make_constant(const Expr* original, const Value& value);
+	};
+
+	const Value* constant_value(const Expr* expr) {
+		return expr && expr->kind == ExprKind::constant ?
+			&static_cast<const Constant*>(expr)->value : nullptr;
+	}
+
+	Value integer_value(std::int64_t value) { return { ValueKind::integer, value }; }
+	Value real_value(double value) { return { ValueKind::real, 0, value }; }
+	Value boolean_value(bool value) { return { ValueKind::boolean, value ? 1 : 0 }; }
+	Value char_value(std::int64_t value) { return { ValueKind::character, value & 0xff }; }
+	Value set_value(std::uint64_t bits) { return { ValueKind::set, static_cast<std::int64_t>(bits) }; }
+
+	// elements of a SET are 0 .. set_bits - 1
+	constexpr std::int64_t set_bits { 64 };
+
+	bool is_true(const Expr* expr) {
+		auto value { constant_value(expr) };
+		return value && value->kind == ValueKind::boolean && value->integer;
+	}
+
+	bool is_false(const Expr* expr) {
+		auto value { constant_value(expr) };
+		return value && value->kind == ValueKind::boolean && !value->integer;
+	}
+
+	// Oberon DIV and MOD round towards negative infinity
+	std::int64_t floor_div(std::int64_t x, std::int64_t y) {
+		auto quotient { x / y };
+		return (x % y != 0 && ((x < 0) != (y < 0))) ? quotient - 1 : quotient;
+	}
+
+	std::int64_t floor_mod(std::int64_t x, std::int64_t y) {
+		auto remainder { x % y };
+		return (remainder != 0 && ((remainder < 0) != (y < 0))) ? remainder + y : remainder;
+	}
+
+	// SYSTEM_INTEGER is 32 bits, so folded integers must stay in its range
+	Value checked_integer(bool overflow, std::int32_t value) {
+		if (overflow) { throw Error { "constant overflow in constant expression" }; }
+		return integer_value(value);
+	}
+
+	Value checked_integer(std::int64_t value) {
+		std::int32_t result;
+		bool overflow { __builtin_add_overflow(value, 0, &result) };
+		return checked_integer(overflow, result);
+	}
+
+	// one character strings can be used as CHAR
+	bool as_char(const Value& value, std::int64_t& ch) {
+		if (value.kind == ValueKind::character) { ch = value.integer; return true; }
+		if (value.kind == ValueKind::string && value.string.size() == 1) {
+			ch = static_cast<unsigned char>(value.string[0]);
+			return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	bool compare(const Token& op, const T& left, const T& right, Value& result) {
+		switch (op) {
+			case Token_equals: result = boolean_value(left == right); return true;
+			case Token_notEquals: result = boolean_value(left != right); return true;
+			case Token_less: result = boolean_value(left < right); return true;
+			case Token_lessOrEqual: result = boolean_value(left <= right); return true;
+			case Token_greater: result = boolean_value(left > right); return true;
+			case Token_greaterOrEqual: result = boolean_value(left >= right); return true;
+			default: return false;
+		}
+	}
+
+	bool evaluate_binary(const Token& op, const Value& left, const Value& right, Value& result) {
+		if (left.kind == ValueKind::integer && right.kind == ValueKind::integer) {
+			auto x { left.integer }, y { right.integer };
+			std::int32_t z;
+			bool overflow;
+			switch (op) {
+				case Token_plus:
+					overflow = __builtin_add_overflow(x, y, &z);
+					result = checked_integer(overflow, z);
+					return true;
+				case Token_minus:
+					overflow = __builtin_sub_overflow(x, y, &z);
+					result = checked_integer(overflow, z);
+					return true;
+				case Token_star:
+					overflow = __builtin_mul_overflow(x, y, &z);
+					result = checked_integer(overflow, z);
+					return true;
+				case Token_slash:
+					result = real_value(static_cast<double>(x) / static_cast<double>(y));
+					return true;
+				case Token_kwDIV: case Token_kwMOD:
+					if (y == 0) { throw Error { "division by zero in constant expression" }; }
+					result = checked_integer(op == Token_kwDIV ? floor_div(x, y) : floor_mod(x, y));
+					return true;
+				default: return compare(op, x, y, result);
+			}
+		}
+		bool numeric {
+			(left.kind == ValueKind::integer || left.kind == ValueKind::real) &&
+			(right.kind == ValueKind::integer || right.kind == ValueKind::real)
+		};
+		if (numeric) {
+			auto x { left.kind == ValueKind::real ? left.real : static_cast<double>(left.integer) };
+			auto y { right.kind == ValueKind::real ? right.real : static_cast<double>(right.integer) };
+			switch (op) {
+				case Token_plus: result = real_value(x + y); return true;
+				case Token_minus: result = real_value(x - y); return true;
+				case Token_star: result = real_value(x * y); return true;
+				case Token_slash: result = real_value(x / y); return true;
+				default: return compare(op, x, y, result);
+			}
+		}
+		if (left.kind == ValueKind::boolean && right.kind == ValueKind::boolean) {
+			switch (op) {
+				case Token_andop: result = boolean_value(left.integer && right.integer); return true;
+				case Token_kwOR: result = boolean_value(left.integer || right.integer); return true;
+				case Token_equals: case Token_notEquals:
+					return compare(op, left.integer, right.integer, result);
+				default: return false;
+			}
+		}
+		if (op == Token_kwIN && left.kind == ValueKind::integer && right.kind == ValueKind::set) {
+			auto bits { static_cast<std::uint64_t>(right.integer) };
+			result = boolean_value(left.integer >= 0 && left.integer < set_bits && ((bits >> left.integer) & 1));
+			return true;
+		}
+		if (left.kind == ValueKind::set && right.kind == ValueKind::set) {
+			auto x { static_cast<std::uint64_t>(left.integer) }, y { static_cast<std::uint64_t>(right.integer) };
+			switch (op) {
+				case Token_plus: result = set_value(x | y); return true;
+				case Token_minus: result = set_value(x & ~y); return true;
+				case Token_star: result = set_value(x & y); return true;
+				case Token_slash: result = set_value(x ^ y); return true;
+				case Token_equals: case Token_notEquals: return compare(op, x, y, result);
+				default: return false;
+			}
+		}
+		std::int64_t x, y;
+		if (as_char(left, x) && as_char(right, y) &&
+			(left.kind == ValueKind::character || right.kind == ValueKind::character)
+		) {
+			return compare(op, x, y, result);
+		}
+		if (left.kind == ValueKind::string && right.kind == ValueKind::string) {
+			return compare(op, left.string, right.string, result);
+		}
+		return false;
+	}
+
+	Folder::Folder(Module& module, Interfaces& interfaces, const std::string& dir):
+		module_ { module }
+	{
+		for (const auto& import : module.imports) {
+			imports_.push_back(
+				import.module.text() == "SYSTEM" ? nullptr :
+					interfaces.find(import.module.text(), dir)
+			);
+		}
+	}
+
+	// true if name is declared in an enclosing scope; constant is set if
+	// the declaration is a constant, and type if it is a type
+	bool Folder::lookup(const Name& name, const ConstDecl*& constant, const TypeDecl** type) const {
+		constant = nullptr;
+		if (type) { *type = nullptr; }
+		for (auto scope { scope_ }; scope; scope = scope->outer) {
+			if (scope->signature) {
+				for (const auto& section : scope->signature->sections) {
+					for (const auto& ident : section.names) {
+						if (ident.name == name) { return true; }
+					}
+				}
+			}
+			const auto& declarations { *scope->declarations };
+			for (const auto* decl : declarations.consts) {
+				if (decl->ident.name == name) { constant = decl; return true; }
+			}
+			for (const auto* decl : declarations.types) {
+				if (decl->ident.name == name) {
+					if (type) { *type = decl; }
+					return true;
+				}
+			}
+			for (const auto* decl : declarations.vars) {
+				for (const auto& ident : decl->names) {
+					if (ident.name == name) { return true; }
+				}
+			}
+			for (const auto* decl : declarations.procedures) {
+				if (decl->ident.name == name) { return true; }
+			}
+		}
+		return false;
+	}
+
+	// expr names a declared or imported type
+	bool Folder::is_type(const Expr* expr) const {
+		if (expr->kind != ExprKind::ident) { return false; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		if (ident.module.empty()) {
+			const ConstDecl* constant;
+			const TypeDecl* type;
+			return lookup(ident.name, constant, &type) && type;
+		}
+		for (std::uint32_t i { 0 }; i < module_.imports.size(); ++i) {
+			if (module_.imports[i].alias != ident.module) { continue; }
+			return imports_[i] && imports_[i]->types.count(ident.name.text());
+		}
+		return false;
+	}
+
+	bool Folder::imported(const QualIdent& ident, Value& value) const {
+		for (std::uint32_t i { 0 }; i < module_.imports.size(); ++i) {
+			if (module_.imports[i].alias != ident.module) { continue; }
+			if (!imports_[i]) { return false; }
+			auto got { imports_[i]->consts.find(ident.name.text()) };
+			if (got == imports_[i]->consts.end()) { return false; }
+			value = got->second;
+			return true;
+		}
+		return false;
+	}
+
+	void Folder::module() {
+		Scope scope { nullptr, &module_.declarations, nullptr };
+		scope_ = &scope;
+		declarations(module_.declarations);
+		module_.body = statements(module_.body);
+		scope_ = nullptr;
+	}
+
+	void Folder::declarations(Declarations& declarations) {
+		for (auto* decl : declarations.consts) {
+			decl->value = expression(decl->value);
+		}
+		for (auto* decl : declarations.types) { type(decl->type); }
+		for (auto* decl : declarations.vars) { type(decl->type); }
+		for (auto* procedure : declarations.procedures) {
+			signature(procedure->signature);
+			this->procedure(*procedure);
+		}
+	}
+
+	void Folder::procedure(ProcDecl& procedure) {
+		Scope scope { scope_, &procedure.declarations, procedure.signature };
+		auto outer { scope_ };
+		scope_ = &scope;
+		declarations(procedure.declarations);
+		procedure.body = statements(procedure.body);
+		if (procedure.result) { procedure.result = expression(procedure.result); }
+		scope_ = outer;
+	}
+
+	void Folder::signature(Signature* signature) {
+		if (!signature) { return; }
+		for (auto& section : signature->sections) { type(section.type); }
+		type(signature->result);
+	}
+
+	// array lengths have to be positive constants
+	void Folder::type(Type* type) {
+		if (!type) { return; }
+		switch (type->kind) {
+			case TypeKind::array: {
+				auto& array { *static_cast<ArrayType*>(type) };
+				for (auto& length : array.lengths) {
+					length = expression(length);
+					auto value { constant_value(length) };
+					if (!value || value->kind != ValueKind::integer) {
+						throw Error { "array length is not a constant integer" };
+					}
+					if (value->integer <= 0) { throw Error { "array length must be positive" }; }
+				}
+				this->type(array.element);
+				break;
+			}
+			case TypeKind::open_array:
+				this->type(static_cast<OpenArrayType*>(type)->element);
+				break;
+			case TypeKind::record: {
+				auto& record { *static_cast<RecordType*>(type) };
+				for (auto& fields : record.fields) { this->type(fields.type); }
+				break;
+			}
+			case TypeKind::pointer:
+				this->type(static_cast<PointerType*>(type)->target);
+				break;
+			case TypeKind::procedure:
+				signature(static_cast<ProcedureType*>(type)->signature);
+				break;
+			default:
+				break;
+		}
+	}
+
+	Statements Folder::statements(const Statements& statements) {
+		std::vector<Stmt*> result;
+		for (auto* statement : statements) {
+			this->statement(statement, result);
+		}
+		return make_span(module_.arena, result);
+	}
+
+	// Drops branches with a FALSE condition. A TRUE condition makes the
+	// following branches unreachable. Returns true if the first remaining
+	// branch always runs.
+	bool Folder::fold_branches(Span<Branch>& branches, bool stop_at_true) {
+		std::vector<Branch> kept;
+		for (auto& branch : branches) {
+			branch.condition = expression(branch.condition);
+			if (is_false(branch.condition)) { continue; }
+			branch.body = statements(branch.body);
+			kept.push_back(branch);
+			if (stop_at_true && is_true(branch.condition)) { break; }
+		}
+		branches = make_span(module_.arena, kept);
+		return !kept.empty() && is_true(kept.front().condition);
+	}
+
+	void Folder::statement(Stmt* statement, std::vector<Stmt*>& result) {
+		switch (statement->kind) {
+			case StmtKind::assignment: {
+				auto& assignment { *static_cast<Assignment*>(statement) };
+				assignment.target = expression(assignment.target);
+				assignment.value = expression(assignment.value);
+				break;
+			}
+			case StmtKind::call: {
+				auto& call { *static_cast<CallStmt*>(statement) };
+				call.call = expression(call.call);
+				break;
+			}
+			case StmtKind::if_then: {
+				auto& if_stmt { *static_cast<IfStmt*>(statement) };
+				if (fold_branches(if_stmt.branches, true)) {
+					// the first branch always runs
+					for (auto* inner : if_stmt.branches[0].body) { result.push_back(inner); }
+					return;
+				}
+				if (is_true(if_stmt.branches.empty() ? nullptr :
+					if_stmt.branches[if_stmt.branches.size() - 1].condition)
+				) {
+					// a TRUE ELSIF replaces the ELSE part
+					auto last { if_stmt.branches[if_stmt.branches.size() - 1] };
+					--if_stmt.branches.count;
+					if_stmt.otherwise = last.body;
+					if_stmt.has_else = true;
+				} else if (if_stmt.has_else) {
+					if_stmt.otherwise = statements(if_stmt.otherwise);
+				}
+				if (if_stmt.branches.empty()) {
+					for (auto* inner : if_stmt.otherwise) { result.push_back(inner); }
+					return;
+				}
+				break;
+			}
+			case StmtKind::case_of:
+				case_statement(*static_cast<CaseStmt*>(statement), result);
+				return;
+			case StmtKind::while_do: {
+				auto& while_stmt { *static_cast<WhileStmt*>(statement) };
+				fold_branches(while_stmt.branches, true);
+				if (while_stmt.branches.empty()) { return; }
+				break;
+			}
+			case StmtKind::repeat_until: {
+				auto& repeat { *static_cast<RepeatStmt*>(statement) };
+				repeat.body = statements(repeat.body);
+				repeat.condition = expression(repeat.condition);
+				if (is_true(repeat.condition)) {
+					for (auto* inner : repeat.body) { result.push_back(inner); }
+					return;
+				}
+				break;
+			}
+			case StmtKind::for_do: {
+				auto& for_stmt { *static_cast<ForStmt*>(statement) };
+				for_stmt.begin = expression(for_stmt.begin);
+				for_stmt.end = expression(for_stmt.end);
+				if (for_stmt.step) {
+					for_stmt.step = expression(for_stmt.step);
+				} else {
+					for_stmt.step = make_constant(for_stmt.end, integer_value(1));
+				}
+				auto step { constant_value(for_stmt.step) };
+				if (!step || step->kind != ValueKind::integer || step->integer == 0) {
+					throw Error { "FOR step must be a constant integer other than 0" };
+				}
+				for_stmt.body = statements(for_stmt.body);
+				// a loop that never runs only sets the control variable
+				auto begin { constant_value(for_stmt.begin) }, end { constant_value(for_stmt.end) };
+				if (begin && end && begin->kind == ValueKind::integer && end->kind == ValueKind::integer &&
+					(step->integer > 0 ? begin->integer > end->integer : begin->integer < end->integer)
+				) {
+					auto control { module_.arena.make<Ident>(
+						Expr { ExprKind::ident, statement->pos }, QualIdent { { }, for_stmt.control }
+					) };
+					result.push_back(module_.arena.make<Assignment>(
+						Stmt { StmtKind::assignment, statement->pos }, control, for_stmt.begin
+					));
+					return;
+				}
+				break;
+			}
+		}
+		result.push_back(statement);
+	}
+
+	// one character strings are CHAR labels
+	Expr* Folder::case_label(Expr* label) {
+		label = expression(label);
+		auto value { constant_value(label) };
+		if (value && value->kind == ValueKind::string && value->string.size() == 1) {
+			return make_constant(label, char_value(static_cast<unsigned char>(value->string[0])));
+		}
+		if (!value || (value->kind != ValueKind::integer && value->kind != ValueKind::character)) {
+			throw Error { "CASE label must be a constant integer or character" };
+		}
+		return label;
+	}
+
+	// Labels must not overlap. A constant selector leaves only the
+	// statements it selects. Labels that name types make a type CASE,
+	// whose branches each test for one type.
+	void Folder::case_statement(CaseStmt& statement, std::vector<Stmt*>& result) {
+		statement.selector = expression(statement.selector);
+		if (!statement.cases.empty() && is_type(statement.cases[0].labels[0].low)) {
+			if (statement.selector->kind != ExprKind::ident) {
+				throw Error { "type CASE selector must be a variable" };
+			}
+			for (auto& item : statement.cases) {
+				if (item.labels.size() != 1 || item.labels[0].high || !is_type(item.labels[0].low)) {
+					throw Error { "type CASE label must be one type" };
+				}
+				item.body = statements(item.body);
+			}
+			if (statement.has_else) { statement.otherwise = statements(statement.otherwise); }
+			statement.type_test = true;
+			result.push_back(&statement);
+			return;
+		}
+		struct Interval {
+			std::int64_t low, high;
+			std::size_t index;
+		};
+		std::vector<Interval> intervals;
+		const Value* first { nullptr };
+		for (std::size_t i { 0 }; i < statement.cases.size(); ++i) {
+			auto& item { statement.cases[i] };
+			for (auto& label : item.labels) {
+				label.low = case_label(label.low);
+				if (label.high) { label.high = case_label(label.high); }
+				auto low { constant_value(label.low) };
+				auto high { label.high ? constant_value(label.high) : low };
+				if (!first) { first = low; }
+				if (low->kind != first->kind || high->kind != first->kind) {
+					throw Error { "CASE labels must be all integers or all characters" };
+				}
+				if (low->integer > high->integer) { throw Error { "empty CASE label range" }; }
+				intervals.push_back({ low->integer, high->integer, i });
+			}
+			item.body = statements(item.body);
+		}
+		if (statement.has_else) { statement.otherwise = statements(statement.otherwise); }
+		std::sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) {
+			return a.low < b.low;
+		});
+		for (std::size_t i { 1 }; i < intervals.size(); ++i) {
+			if (intervals[i].low <= intervals[i - 1].high) { throw Error { "CASE labels overlap" }; }
+		}
+
+		auto selector { constant_value(statement.selector) };
+		if (!selector || (selector->kind != ValueKind::integer && selector->kind != ValueKind::character)) {
+			result.push_back(&statement);
+			return;
+		}
+		for (const auto& interval : intervals) {
+			if (selector->integer >= interval.low && selector->integer <= interval.high) {
+				for (auto* inner : statement.cases[interval.index].body) { result.push_back(inner); }
+				return;
+			}
+		}
+		if (!statement.has_else) {
+			// traps at run time
+			result.push_back(&statement);
+			return;
+		}
+		for (auto* inner : statement.otherwise) { result.push_back(inner); }
+	}
+
+	Expr* Folder::make_constant(const Expr* original, const Value& value) {
+		return module_.arena.make<Constant>(Expr { ExprKind::constant, original->pos }, value);
+	}
+
+	Expr* Folder::expression(Expr* expr) {
+		switch (expr->kind) {
+			case ExprKind::integer: {
+				// hexadecimal literals are the 32 bits of the integer, so
+				// 0FFFFFFFFH is -1
+				auto text { static_cast<Literal*>(expr)->text };
+				bool hex { text.back() == 'H' };
+				if (hex) { text.remove_suffix(1); }
+				std::int64_t limit { hex ? 0xFFFFFFFF : INT32_MAX };
+				std::int64_t value { 0 };
+				for (char ch : text) {
+					value = value * (hex ? 16 : 10) + (ch <= '9' ? ch - '0' : ch - 'A' + 10);
+					if (value > limit) { throw Error { "integer literal out of range" }; }
+				}
+				if (value > INT32_MAX) { value -= std::int64_t { 1 } << 32; }
+				return make_constant(expr, integer_value(value));
+			}
+			case ExprKind::real:
+				return make_constant(
+					expr, real_value(std::strtod(std::string { static_cast<Literal*>(expr)->text }.c_str(), nullptr))
+				);
+			case ExprKind::character: {
+				std::int64_t value { 0 };
+				for (char ch : static_cast<Literal*>(expr)->text) {
+					value = value * 16 + (ch <= '9' ? ch - '0' : ch - 'A' + 10);
+					if (value > 0xFF) { throw Error { "character literal out of range" }; }
+				}
+				return make_constant(expr, char_value(value));
+			}
+			case ExprKind::string: {
+				Value value { ValueKind::string };
+				value.string = static_cast<Literal*>(expr)->text;
+				return make_constant(expr, value);
+			}
+			case ExprKind::boolean:
+				return make_constant(expr, boolean_value(static_cast<BooleanLiteral*>(expr)->value));
+			case ExprKind::ident:
+				return ident(static_cast<Ident*>(expr));
+			case ExprKind::field: {
+				auto& field { *static_cast<Field*>(expr) };
+				field.base = expression(field.base);
+				return expr;
+			}
+			case ExprKind::index: {
+				auto& index { *static_cast<Index*>(expr) };
+				index.base = expression(index.base);
+				for (auto& item : index.indices) { item = expression(item); }
+				return expr;
+			}
+			case ExprKind::deref: {
+				auto& deref { *static_cast<Deref*>(expr) };
+				deref.base = expression(deref.base);
+				return expr;
+			}
+			case ExprKind::call:
+				return call(static_cast<Call*>(expr));
+			case ExprKind::unary:
+				return unary(static_cast<Unary*>(expr));
+			case ExprKind::binary:
+				return binary(static_cast<Binary*>(expr));
+			case ExprKind::set:
+				return set(static_cast<SetExpr*>(expr));
+			case ExprKind::paren: {
+				auto& paren { *static_cast<Paren*>(expr) };
+				paren.inner = expression(paren.inner);
+				return paren.inner->kind == ExprKind::constant ? paren.inner : expr;
+			}
+			default:
+				return expr;
+		}
+	}
+
+	Expr* Folder::ident(Ident* ident) {
+		Value value;
+		if (!ident->ident.module.empty()) {
+			return imported(ident->ident, value) ? make_constant(ident, value) : ident;
+		}
+		const ConstDecl* constant;
+		if (lookup(ident->ident.name, constant) && constant) {
+			if (auto folded { constant_value(constant->value) }) {
+				return make_constant(ident, *folded);
+			}
+		}
+		return ident;
+	}
+
+	// predeclared functions with constant arguments
+	Expr* Folder::call(Call* call) {
+		call->procedure = expression(call->procedure);
+		bool all_constant { true };
+		for (auto& argument : call->arguments) {
+			argument = expression(argument);
+			all_constant = all_constant && argument->kind == ExprKind::constant;
+		}
+		if (!all_constant || call->arguments.size() != 1 ||
+			call->procedure->kind != ExprKind::ident
+		) {
+			return call;
+		}
+		const auto& ident { static_cast<const Ident*>(call->procedure)->ident };
+		const ConstDecl* ignored;
+		if (!ident.module.empty() || lookup(ident.name, ignored)) { return call; }
+
+		auto name { ident.name.text() };
+		const auto& argument { *constant_value(call->arguments[0]) };
+		std::int64_t ch;
+		if (name == "ABS" && argument.kind == ValueKind::integer) {
+			return make_constant(call, checked_integer(std::abs(argument.integer)));
+		} else if (name == "ABS" && argument.kind == ValueKind::real) {
+			return make_constant(call, real_value(std::fabs(argument.real)));
+		} else if (name == "ODD" && argument.kind == ValueKind::integer) {
+			return make_constant(call, boolean_value(floor_mod(argument.integer, 2) == 1));
+		} else if (name == "ORD" && as_char(argument, ch)) {
+			return make_constant(call, integer_value(ch));
+		} else if (name == "ORD" && argument.kind == ValueKind::boolean) {
+			return make_constant(call, integer_value(argument.integer));
+		} else if (name == "CHR" && argument.kind == ValueKind::integer) {
+			if (argument.integer < 0 || argument.integer > 0xFF) { throw Error { "CHR argument out of range" }; }
+			return make_constant(call, char_value(argument.integer));
+		} else if (name == "FLT" && argument.kind == ValueKind::integer) {
+			return make_constant(call, real_value(static_cast<double>(argument.integer)));
+		} else if (name == "FLOOR" && argument.kind == ValueKind::real) {
+			auto value { std::floor(argument.real) };
+			bool overflow { !(value >= INT32_MIN && value <= INT32_MAX) };
+			return make_constant(call, checked_integer(overflow, overflow ? 0 : static_cast<std::int32_t>(value)));
+		}
+		return call;
+	}
+
+	Expr* Folder::unary(Unary* unary) {
+		unary->operand = expression(unary->operand);
+		auto value { constant_value(unary->operand) };
+		if (!value) { return unary; }
+		if (unary->op == Token_notop && value->kind == ValueKind::boolean) {
+			return make_constant(unary, boolean_value(!value->integer));
+		} else if (unary->op == Token_minus && value->kind == ValueKind::integer) {
+			std::int32_t result;
+			bool overflow { __builtin_sub_overflow(std::int64_t { 0 }, value->integer, &result) };
+			return make_constant(unary, checked_integer(overflow, result));
+		} else if (unary->op == Token_minus && value->kind == ValueKind::real) {
+			return make_constant(unary, real_value(-value->real));
+		} else if (unary->op == Token_minus && value->kind == ValueKind::set) {
+			return make_constant(unary, set_value(~static_cast<std::uint64_t>(value->integer)));
+		} else if (unary->op == Token_plus && value->kind != ValueKind::boolean) {
+			return unary->operand;
+		}
+		return unary;
+	}
+
+	Expr* Folder::binary(Binary* binary) {
+		binary->left = expression(binary->left);
+		binary->right = expression(binary->right);
+
+		// & and OR don't evaluate their right operand if the left decides
+		if (binary->op == Token_andop) {
+			if (is_false(binary->left)) { return binary->left; }
+			if (is_true(binary->left)) { return binary->right; }
+		} else if (binary->op == Token_kwOR) {
+			if (is_true(binary->left)) { return binary->left; }
+			if (is_false(binary->left)) { return binary->right; }
+		}
+
+		auto left { constant_value(binary->left) };
+		auto right { constant_value(binary->right) };
+		Value result;
+		if (left && right && evaluate_binary(binary->op, *left, *right, result)) {
+			return make_constant(binary, result);
+		}
+		return binary;
+	}
+
+	// a set of constant elements is a constant
+	Expr* Folder::set(SetExpr* set) {
+		std::uint64_t bits { 0 };
+		bool all_constant { true };
+		auto element = [&](Expr*& expr) -> const Value* {
+			expr = expression(expr);
+			auto value { constant_value(expr) };
+			if (!value) {
+				all_constant = false;
+			} else if (value->kind != ValueKind::integer || value->integer < 0 || value->integer >= set_bits) {
+				throw Error { "set element must be an integer in 0 .. 63" };
+			}
+			return value;
+		};
+		for (auto& item : set->elements) {
+			auto low { element(item.low) };
+			auto high { item.high ? element(item.high) : low };
+			if (!low || !high) { continue; }
+			for (auto i { low->integer }; i <= high->integer; ++i) { bits |= std::uint64_t { 1 } << i; }
+		}
+		return all_constant ? make_constant(set, set_value(bits)) : set;
+	}
+}
+
+void fold_module(Module& module, Interfaces& interfaces, const std::string& dir) {
+	Folder { module, interfaces, dir }.module();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include "ast.h"
+
+class Interfaces;
+
+// Replaces constant expressions by their values, inlines the constants of
+// imported modules and drops branches that can never run. dir is the
+// directory of the module, imported modules are searched there first.
+void fold_module(Module& module, Interfaces& interfaces, const std::string& dir);
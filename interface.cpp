@@ -0,0 +1,231 @@
+#include "interface.h"
+
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "fold.h"
+#include "parser.h"
+#include "source.h"
+#include "symbols.h"
+
+namespace {
+	bool is_file(const std::string& path) {
+		struct stat info { };
+		return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+	}
+
+	bool file_times(const std::string& path, std::int64_t& mtime, std::int64_t& size) {
+		struct stat info { };
+		if (::stat(path.c_str(), &info) != 0) { return false; }
+		mtime = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+		size = static_cast<std::int64_t>(info.st_size);
+		return true;
+	}
+
+	std::string search(
+		std::string_view name, const char* extension, const std::string& dir,
+		const std::vector<std::string>& search_path
+	) {
+		auto candidate { dir + std::string { name } + extension };
+		if (is_file(candidate)) { return candidate; }
+		for (const auto& search_dir : search_path) {
+			candidate = search_dir + "/" + std::string { name } + extension;
+			if (is_file(candidate)) { return candidate; }
+		}
+		return { };
+	}
+
+	SourceStamp make_stamp(const std::string& path, const Source& source) {
+		SourceStamp stamp { path };
+		file_times(path, stamp.mtime, stamp.size);
+		stamp.hash = Hash { }.add(source.text()).value();
+		return stamp;
+	}
+}
+
+bool SourceStamp::unchanged() const {
+	std::int64_t current_mtime, current_size;
+	if (!file_times(path, current_mtime, current_size)) { return false; }
+	if (current_mtime == mtime && current_size == size) { return true; }
+	try {
+		Source source { path };
+		return Hash { }.add(source.text()).value() == hash;
+	}
+	catch (const std::runtime_error&) {
+		return false;
+	}
+}
+
+std::shared_ptr<const ModuleInterface> InterfaceStore::get(const std::string& path) {
+	std::shared_ptr<const ModuleInterface> interface;
+	{
+		std::lock_guard lock { mutex_ };
+		auto got { by_path_.find(path) };
+		if (got == by_path_.end()) { return nullptr; }
+		interface = got->second;
+	}
+	for (const auto& source : interface->sources) {
+		if (!source.unchanged()) { return nullptr; }
+	}
+	return interface;
+}
+
+void InterfaceStore::put(std::shared_ptr<const ModuleInterface> interface) {
+	std::lock_guard lock { mutex_ };
+	by_path_[interface->path] = std::move(interface);
+}
+
+std::string directory_of(const std::string& path) {
+	return path.substr(0, path.rfind('/') + 1);
+}
+
+std::string symbols_path(const std::string& source_path) {
+	return source_path.substr(0, source_path.size() - 4) + ".smb";
+}
+
+std::string Interfaces::find_source(std::string_view name, const std::string& dir) const {
+	return search(name, ".Mod", dir, search_path_);
+}
+
+std::string Interfaces::find_symbols(std::string_view name, const std::string& dir) const {
+	return search(name, ".smb", dir, search_path_);
+}
+
+const ModuleInterface* Interfaces::find(std::string_view name, const std::string& dir) {
+	auto got { loaded_.find(name) };
+	if (got != loaded_.end()) { return got->second.get(); }
+
+	auto source_path { find_source(name, dir) };
+	auto symbol_path {
+		source_path.empty() ? find_symbols(name, dir) : symbols_path(source_path)
+	};
+	auto key { source_path.empty() ? symbol_path : source_path };
+	std::shared_ptr<const ModuleInterface> interface;
+	if (!key.empty()) {
+		interface = store_.get(key);
+	}
+	if (!key.empty() && !interface) {
+		if (loading_.count(name)) {
+			throw std::runtime_error { "import cycle through " + std::string { name } };
+		}
+		loading_.emplace(name);
+		try {
+			if (is_file(symbol_path)) {
+				interface = load_symbols(symbol_path, source_path);
+			}
+			if (!interface && !source_path.empty()) {
+				interface = load(source_path, name);
+			}
+		}
+		catch (...) {
+			loading_.erase(loading_.find(name));
+			throw;
+		}
+		loading_.erase(loading_.find(name));
+		if (interface) { store_.put(interface); }
+	}
+	auto result { interface.get() };
+	loaded_.emplace(std::string { name }, std::move(interface));
+	return result;
+}
+
+std::vector<const ModuleInterface*> Interfaces::resolve(
+	const Module& module, const std::string& dir
+) {
+	std::vector<const ModuleInterface*> result;
+	for (const auto& import : module.imports) {
+		result.push_back(
+			import.module.text() == "SYSTEM" ? nullptr : find(import.module.text(), dir)
+		);
+	}
+	return result;
+}
+
+void Interfaces::add_dependencies(ModuleInterface& interface, const std::string& dir) {
+	for (const auto& [name, fingerprint] : interface.dependencies) {
+		auto used { find(name, dir) };
+		if (!used) { continue; }
+		for (const auto& stamp : used->sources) {
+			bool known { false };
+			for (const auto& source : interface.sources) {
+				known = known || source.path == stamp.path;
+			}
+			if (!known) { interface.sources.push_back(stamp); }
+		}
+	}
+}
+
+// nullptr if the symbol file is unusable or out of date
+std::shared_ptr<const ModuleInterface> Interfaces::load_symbols(
+	const std::string& path, const std::string& source_path
+) {
+	std::shared_ptr<ModuleInterface> interface;
+	SourceStamp stamp;
+	try {
+		Source file { path };
+		interface = read_symbols(file.text());
+		stamp = make_stamp(path, file);
+	}
+	catch (const std::runtime_error&) {
+		return nullptr;
+	}
+	if (!source_path.empty()) {
+		Source source { source_path };
+		stamp = make_stamp(source_path, source);
+		if (stamp.hash != interface->source_hash) { return nullptr; }
+	}
+	interface->path = stamp.path;
+	interface->sources.push_back(stamp);
+
+	auto dir { directory_of(stamp.path) };
+	for (const auto& [name, fingerprint] : interface->dependencies) {
+		auto used { find(name, dir) };
+		if (!used || used->fingerprint != fingerprint) { return nullptr; }
+	}
+	add_dependencies(*interface, dir);
+	return interface;
+}
+
+std::shared_ptr<const ModuleInterface> Interfaces::load(
+	const std::string& path, std::string_view name
+) {
+	Source source { path };
+	Module module;
+	parse_module(std::string { name }, source, module);
+	auto dir { directory_of(path) };
+	fold_module(module, *this, dir);
+
+	auto stamp { make_stamp(path, source) };
+	auto interface { read_symbols(write_symbols(module, stamp.hash, resolve(module, dir))) };
+	interface->path = path;
+	interface->sources.push_back(stamp);
+	add_dependencies(*interface, dir);
+	return interface;
+}
+
+std::vector<std::string> Interfaces::import_sources(
+	const std::vector<std::string>& imports, const std::string& dir
+) const {
+	std::vector<std::string> result;
+	std::set<std::string> seen;
+	std::vector<std::pair<std::string, std::string>> pending;
+	for (const auto& name : imports) { pending.emplace_back(name, dir); }
+	while (!pending.empty()) {
+		auto [name, from] { pending.back() };
+		pending.pop_back();
+		if (!seen.insert(name).second) { continue; }
+		auto path { find_source(name, from) };
+		if (path.empty()) { continue; }
+		result.push_back(path);
+		try {
+			for (auto& imported : read_module_header(path).imports) {
+				pending.emplace_back(std::move(imported), directory_of(path));
+			}
+		}
+		catch (const std::runtime_error&) {
+			// reported when the interface is loaded
+		}
+	}
+	return result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+
+// State of a source file when an interface was read from it
+struct SourceStamp {
+	std::string path;
+	std::int64_t mtime { 0 };
+	std::int64_t size { 0 };
+	std::uint64_t hash { 0 };
+
+	// unchanged if mtime and size match or the content hash does
+	bool unchanged() const;
+};
+
+// Exported declarations of a module as seen by its importers. Type
+// names are qualified by the full module name unless predeclared.
+struct ModuleInterface {
+	std::string name;
+	std::string path;
+	std::uint64_t fingerprint { 0 };
+	std::uint64_t source_hash { 0 };
+	// fingerprints of the imported interfaces the constants were folded with
+	std::vector<std::pair<std::string, std::uint64_t>> dependencies;
+	// the files the interface was read from and those of its dependencies
+	std::vector<SourceStamp> sources;
+	Arena arena;
+	Interner names;
+	std::map<std::string, Value, std::less<>> consts;
+	std::map<std::string, const Type*, std::less<>> types;
+	std::map<std::string, const Type*, std::less<>> vars;
+	std::map<std::string, const Signature*, std::less<>> procedures;
+};
+
+// Interfaces shared by all translations of one process, keyed by source
+// path. Entries are checked against their sources before they are used.
+// Thread safe.
+class InterfaceStore {
+	private:
+		std::mutex mutex_;
+		std::map<std::string, std::shared_ptr<const ModuleInterface>, std::less<>> by_path_;
+
+	public:
+		std::shared_ptr<const ModuleInterface> get(const std::string& path);
+		void put(std::shared_ptr<const ModuleInterface> interface);
+};
+
+// Loads the interfaces of imported modules. Modules are searched next to
+// the importing module and then in the search path. A symbol file next
+// to the source is used if it was written for the current source and
+// the interfaces it depends on are unchanged; otherwise the source is
+// parsed. A symbol file without source (for a hand written module) is
+// used as is. One Interfaces object serves one translation and keeps
+// the interfaces it handed out alive.
+class Interfaces {
+	private:
+		std::vector<std::string> search_path_;
+		InterfaceStore& store_;
+		std::map<std::string, std::shared_ptr<const ModuleInterface>, std::less<>> loaded_;
+		std::set<std::string, std::less<>> loading_;
+
+		std::shared_ptr<const ModuleInterface> load(const std::string& path, std::string_view name);
+		std::shared_ptr<const ModuleInterface> load_symbols(
+			const std::string& path, const std::string& source_path
+		);
+		void add_dependencies(ModuleInterface& interface, const std::string& dir);
+
+	public:
+		Interfaces(std::vector<std::string> search_path, InterfaceStore& store):
+			search_path_ { std::move(search_path) }, store_ { store }
+		{ }
+
+		std::string find_source(std::string_view name, const std::string& dir) const;
+		std::string find_symbols(std::string_view name, const std::string& dir) const;
+		const ModuleInterface* find(std::string_view name, const std::string& dir);
+
+		// interfaces of module.imports, nullptr for SYSTEM and unknown modules
+		std::vector<const ModuleInterface*> resolve(const Module& module, const std::string& dir);
+
+		// sources of all modules that name imports directly or indirectly
+		std::vector<std::string> import_sources(
+			const std::vector<std::string>& imports, const std::string& dir
+		) const;
+};
+
+std::string directory_of(const std::string& path);
+std::string symbols_path(const std::string& source_path);
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "keywords.h"
+
+// Compares the perfect hash in keywords.h against the std::map lookup the
+// scanner used before. The corpus mimics generated Oberon code: mostly
+// identifiers with a keyword every few words.
+
+static const std::map<std::string, SYSTEM_INTEGER, std::less<>> map_keywords {
+	[] {
+		std::map<std::string, SYSTEM_INTEGER, std::less<>> result;
+		for (const auto& keyword : keyword_list) {
+			result.emplace(keyword.text, keyword.token);
+		}
+		return result;
+	}()
+};
+
+static SYSTEM_INTEGER map_lookup(std::string_view text) {
+	auto got { map_keywords.find(text) };
+	return got == map_keywords.end() ? Token_identifier : got->second;
+}
+
+static std::vector<std::string> build_corpus(std::size_t count) {
+	static const char* const identifiers[] {
+		"i", "x", "ch", "token", "Scanner", "isDigit", "value", "Out",
+		"WriteInt", "result", "CONSTANT", "ENDING", "position", "Buffer",
+		"ReadChar", "MODULEs", "lastError", "t", "Texts", "Writer"
+	};
+	std::vector<std::string> corpus;
+	corpus.reserve(count);
+	std::uint32_t seed { 12345 };
+	for (std::size_t i { 0 }; i < count; ++i) {
+		seed = seed * 1103515245u + 12345u;
+		if (i % 4 == 0) {
+			corpus.emplace_back(keyword_list[(seed >> 8) % keyword_list.size()].text);
+		} else {
+			corpus.emplace_back(identifiers[(seed >> 8) % std::size(identifiers)]);
+		}
+	}
+	return corpus;
+}
+
+template<typename Lookup>
+static void run(const char* name, const std::vector<std::string>& corpus, Lookup lookup) {
+	constexpr int rounds { 20 };
+	long checksum { 0 };
+	auto start { std::chrono::steady_clock::now() };
+	for (int round { 0 }; round < rounds; ++round) {
+		for (const auto& text : corpus) { checksum += lookup(text); }
+	}
+	std::chrono::duration<double> took { std::chrono::steady_clock::now() - start };
+	auto lookups { static_cast<double>(corpus.size()) * rounds };
+	std::cout << name << ": " << took.count() * 1e9 / lookups << " ns/identifier, " <<
+		lookups / took.count() / 1e6 << " M identifiers/s (checksum " <<
+		checksum << ")\n";
+}
+
+int main() {
+	auto corpus { build_corpus(1000000) };
+	run("std::map     ", corpus, map_lookup);
+	run("perfect hash ", corpus, keyword_token);
+}
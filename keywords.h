@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "Token.h"
+
+// Perfect hash over the Oberon keywords. The multiplier is searched at
+// compile time, so adding a keyword only needs an entry in the list.
+
+struct Keyword {
+	std::string_view text;
+	SYSTEM_INTEGER token;
+};
+
+constexpr std::array<Keyword, 33> keyword_list { {
+	{ "ARRAY", Token_kwARRAY }, { "BEGIN", Token_kwBEGIN },
+	{ "BY", Token_kwBY }, { "CASE", Token_kwCASE }, { "CONST", Token_kwCONST },
+	{ "DIV", Token_kwDIV }, { "DO", Token_kwDO }, { "END", Token_kwEND},
+	{ "ELSE", Token_kwELSE }, { "ELSIF", Token_kwELSIF },
+	{ "FALSE", Token_kwFALSE }, { "FOR", Token_kwFOR }, { "IF", Token_kwIF },
+	{ "IMPORT", Token_kwIMPORT }, { "IN", Token_kwIN }, { "IS", Token_kwIS },
+	{ "MOD", Token_kwMOD }, { "MODULE", Token_kwMODULE },
+	{ "NIL", Token_kwNIL }, { "OF", Token_kwOF }, { "OR", Token_kwOR },
+	{ "POINTER", Token_kwPOINTER }, { "PROCEDURE", Token_kwPROCEDURE },
+	{ "RECORD", Token_kwRECORD }, { "REPEAT", Token_kwREPEAT },
+	{ "RETURN", Token_kwRETURN }, { "THEN", Token_kwTHEN },
+	{ "TO", Token_kwTO }, { "TRUE", Token_kwTRUE }, { "TYPE", Token_kwTYPE },
+	{ "UNTIL", Token_kwUNTIL }, { "VAR", Token_kwVAR },
+	{ "WHILE", Token_kwWHILE }
+} };
+
+constexpr std::size_t keyword_min_length { 2 };
+constexpr std::size_t keyword_max_length { 9 };
+constexpr int keyword_hash_bits { 7 };
+
+// first, second and last character plus the length identify a keyword
+constexpr std::uint32_t keyword_key(std::string_view text) {
+	return static_cast<std::uint8_t>(text[0]) |
+		static_cast<std::uint8_t>(text[1]) << 8 |
+		static_cast<std::uint32_t>(static_cast<std::uint8_t>(text.back())) << 16 |
+		static_cast<std::uint32_t>(text.size()) << 24;
+}
+
+constexpr std::size_t keyword_slot(std::string_view text, std::uint32_t factor) {
+	return static_cast<std::uint32_t>(keyword_key(text) * factor) >>
+		(32 - keyword_hash_bits);
+}
+
+constexpr std::uint32_t keyword_factor_candidate(std::uint32_t i) {
+	return (i * 2654435761u) | 1u;
+}
+
+constexpr bool keyword_factor_is_perfect(std::uint32_t factor) {
+	std::array<bool, 1 << keyword_hash_bits> used { };
+	for (const auto& keyword : keyword_list) {
+		auto slot { keyword_slot(keyword.text, factor) };
+		if (used[slot]) { return false; }
+		used[slot] = true;
+	}
+	return true;
+}
+
+constexpr std::uint32_t find_keyword_factor() {
+	for (std::uint32_t i { 1 }; i < 10000; ++i) {
+		if (keyword_factor_is_perfect(keyword_factor_candidate(i))) {
+			return keyword_factor_candidate(i);
+		}
+	}
+	return 0;
+}
+
+constexpr std::uint32_t keyword_factor { find_keyword_factor() };
+static_assert(keyword_factor != 0, "no perfect hash for the keyword list");
+
+constexpr auto build_keyword_table() {
+	std::array<Keyword, 1 << keyword_hash_bits> table { };
+	for (const auto& keyword : keyword_list) {
+		table[keyword_slot(keyword.text, keyword_factor)] = keyword;
+	}
+	return table;
+}
+
+constexpr auto keyword_table { build_keyword_table() };
+
+// Token_identifier for everything that is not a keyword
+constexpr SYSTEM_INTEGER keyword_token(std::string_view text) {
+	if (text.size() < keyword_min_length || text.size() > keyword_max_length) {
+		return Token_identifier;
+	}
+	const auto& candidate { keyword_table[keyword_slot(text, keyword_factor)] };
+	return candidate.text == text ? candidate.token : Token_identifier;
+}
+
+constexpr bool keyword_table_is_complete() {
+	for (const auto& keyword : keyword_list) {
+		if (keyword_token(keyword.text) != keyword.token) { return false; }
+	}
+	return true;
+}
+static_assert(keyword_table_is_complete(), "keyword lookup lost an entry");
@@ -1,959 +1,711 @@
+#include <condition_variable>
+#include <functional>
 #include <iostream>
-#include <fstream>
 #include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-#include "Scanner.h"
+#include "ast.h"
+#include "cache.h"
+#include "emit.h"
+#include "fold.h"
+#include "interface.h"
+#include "parser.h"
+#include "pool.h"
+#include "reach.h"
+#include "server.h"
+#include "source.h"
+#include "symbols.h"
+
+// Bump whenever the generated code changes, it invalidates the cache
+constexpr std::string_view translator_version { "o2c++ 23" };
+
+struct Options {
+	bool use_cache { true };
+	std::string cache_dir;
+	bool write_depfile { false };
+	std::string deps_format;
+	std::vector<std::string> search_path;
+	std::string link_path;
+	bool write_main { false };
+	std::string unity_path;
+	// drop the declarations the program cannot reach
+	bool strip { false };
+	// array indices trap if out of range
+	bool checked { true };
+	// list the index checks that remain in the generated code
+	bool report_checks { false };
+	// mark FOR loops with independent iterations for vectorization
+	bool simd { false };
+	// shared by all translations of the process
+	InterfaceStore* interfaces { nullptr };
+};
 
-void convert(const std::string& path);
+// Returns false if the module has no initializer; in unity mode the
+// generated code is returned in unity_code instead of being written.
+// keep holds the declarations the program reaches, without it those
+// the module reaches from its body and exports are kept.
+bool convert(
+	const std::string& path, const Options& options, std::ostream& log,
+	const std::set<std::string>* keep, std::string& unity_code
+);
 
 using Error = std::runtime_error;
 
-int main(int argc, const char** argv) {
-	Scanner_init_module();
-	try {
-		for (int i = 1; i < argc; ++i) {
-			convert(argv[i]);
-		}
-	}
-	catch (const Error& err) {
-		std::cerr << err.what() << "\n";
-		return EXIT_FAILURE;
-	}
-	return EXIT_SUCCESS;
-}
-
-using Token = SYSTEM_INTEGER;
-
-struct State {
-	const std::string base;
-	std::ifstream& in;
-	std::ofstream& h;
-	std::ofstream& cxx;
-	int ch { ' ' };
-
-	std::string value { };
-	std::map<std::string, std::string> module_mapping;
-	int level { 1 };
-
-	void next();
-	void add_ch_to_value();
-	void set_token(const Token& tok);
-	void set_bi_char_token(char trigger, const Token& with_trigger, const Token& others);
-	void do_comment();
-	void indent();
-
-	void advance();
-
-	State(
-		std::string base, std::ifstream& in,
-		std::ofstream& h, std::ofstream& cxx
-	):
-		base { std::move(base) }, in { in }, h { h }, cxx { cxx }
-	{ module_mapping["SYSTEM"] = "SYSTEM"; Scanner_token = Token_unknown; advance(); }
-
-	void expect(const Token& token) const;
-	void consume(const Token& token);
+// Imports between the modules of one o2c++ call
+struct ModuleGraph {
+	std::vector<ModuleHeader> headers;
+	std::vector<std::vector<std::size_t>> imports;
+	std::vector<std::vector<std::size_t>> dependents;
+	std::vector<std::size_t> order;
 };
 
-void State::indent() {
-	for (int i { level }; i > 0; --i) { cxx << '\t'; }
-}
-
-std::string token_name(const Token& token, const std::string& value) {
-	switch (token) {
-		case Token_unknown: return "unknown";
-		case Token_eof: return "eof";
-		case Token_identifier:	return "identifier " + value;
-		case Token_integerLiteral: return "integer " + value;
-		case Token_floatLiteral: return "float " + value;
-		case Token_stringLiteral: return "\"" + value + "\"";
-		case Token_charLiteral: return "'\\x" + value + "'";
-		case Token_plus: return "+";
-		case Token_minus: return "-";
-		case Token_star: return "*";
-		case Token_slash: return "/";
-		case Token_leftParenthesis: return "(";
-		case Token_rightParenthesis: return ")";
-		case Token_semicolon: return ";";
-		case Token_period: return ".";
-		case Token_comma: return ",";
-		case Token_colon: return ":";
-		case Token_assign: return ":=";
-		case Token_equals: return "=";
-		case Token_bar: return "|";
-		case Token_notEquals: return "#";
-		case Token_leftBracket: return "[";
-		case Token_rightBracket: return "]";
-		case Token_ptr: return "^";
-		case Token_andop: return "&";
-		case Token_notop: return "~";
-		case Token_leftBrace: return "{";
-		case Token_rightBrace: return "}";
-		case Token_less: return "<";
-		case Token_lessOrEqual: return "<=";
-		case Token_greater: return ">";
-		case Token_greaterOrEqual: return ">=";
-		case Token_range: return "..";
-		case Token_kwARRAY: return "ARRAY";
-		case Token_kwBEGIN: return "BEGIN";
-		case Token_kwBY: return "BY";
-		case Token_kwCASE: return "CASE";
-		case Token_kwCONST: return "CONST";
-		case Token_kwDIV: return "DIV";
-		case Token_kwDO: return "DO";
-		case Token_kwEND: return "END";
-		case Token_kwELSE: return "ELSE";
-		case Token_kwELSIF: return "ELSIF";
-		case Token_kwFALSE: return "FALSE";
-		case Token_kwFOR: return "FOR";
-		case Token_kwIF: return "IF";
-		case Token_kwIMPORT: return "IMPORT";
-		case Token_kwIN: return "IN";
-		case Token_kwIS: return "IS";
-		case Token_kwMOD: return "MOD";
-		case Token_kwMODULE: return "MODULE";
-		case Token_kwNIL: return "NIL";
-		case Token_kwOF: return "OF";
-		case Token_kwOR: return "OR";
-		case Token_kwPOINTER: return "POINTER";
-		case Token_kwPROCEDURE: return "PROCEDURE";
-		case Token_kwRECORD: return "RECORD";
-		case Token_kwREPEAT: return "REPEAT";
-		case Token_kwRETURN: return "RETURN";
-		case Token_kwTHEN: return "THEN";
-		case Token_kwTO: return "TO";
-		case Token_kwTRUE: return "TRUE";
-		case Token_kwTYPE: return "TYPE";
-		case Token_kwUNTIL: return "UNTIL";
-		case Token_kwVAR: return "VAR";
-		case Token_kwWHILE: return "WHILE";
-		default: return "??";
+std::string describe_cycle(const ModuleGraph& graph, std::vector<bool> placed) {
+	// every remaining module imports another remaining one, so walking
+	// the imports must reach some module twice
+	std::vector<std::size_t> path;
+	std::vector<std::size_t> seen_at(graph.headers.size(), graph.headers.size());
+	std::size_t current { 0 };
+	while (placed[current]) { ++current; }
+	while (seen_at[current] == graph.headers.size()) {
+		seen_at[current] = path.size();
+		path.push_back(current);
+		for (auto imported : graph.imports[current]) {
+			if (!placed[imported]) { current = imported; break; }
+		}
 	}
-}
-
-void State::expect(const Token& tok) const {
-	if (tok != Scanner_token) {
-		throw Error {
-			"wrong token " + token_name(Scanner_token, value) +
-			" (expected " + token_name(tok, "") + ")"
-		};
+	std::string result { "import cycle: " };
+	for (auto i { seen_at[current] }; i < path.size(); ++i) {
+		result += graph.headers[path[i]].name + " -> ";
 	}
+	return result + graph.headers[current].name;
 }
 
-std::map<std::string, Token> keywords {
-	{ "ARRAY", Token_kwARRAY }, { "BEGIN", Token_kwBEGIN },
-	{ "BY", Token_kwBY }, { "CASE", Token_kwCASE }, { "CONST", Token_kwCONST },
-	{ "DIV", Token_kwDIV }, { "DO", Token_kwDO }, { "END", Token_kwEND},
-	{ "ELSE", Token_kwELSE }, { "ELSIF", Token_kwELSIF },
-	{ "FALSE", Token_kwFALSE }, { "FOR", Token_kwFOR }, { "IF", Token_kwIF },
-	{ "IMPORT", Token_kwIMPORT }, { "IN", Token_kwIN }, { "IS", Token_kwIS },
-	{ "MOD", Token_kwMOD }, { "MODULE", Token_kwMODULE },
-	{ "NIL", Token_kwNIL }, { "OF", Token_kwOF }, { "OR", Token_kwOR },
-	{ "POINTER", Token_kwPOINTER }, { "PROCEDURE", Token_kwPROCEDURE },
-	{ "RECORD", Token_kwRECORD }, { "REPEAT", Token_kwREPEAT },
-	{ "RETURN", Token_kwRETURN }, { "THEN", Token_kwTHEN },
-	{ "TO", Token_kwTO }, { "TRUE", Token_kwTRUE }, { "TYPE", Token_kwTYPE },
-	{ "UNTIL", Token_kwUNTIL }, { "VAR", Token_kwVAR },
-	{ "WHILE", Token_kwWHILE }
-};
-
-void State::add_ch_to_value() {
-	value += static_cast<char>(ch);
-	ch = in.get();
-}
-
-void State::next() { if (ch != EOF) { ch = in.get(); } }
-void State::set_token(const Token& tok) { Scanner_token = tok; next(); }
-
-void State::set_bi_char_token(
-	char trigger, const Token& with_trigger, const Token& others
-) {
-	next();
-	if (ch == trigger) {
-		set_token(with_trigger);
-	} else {
-		Scanner_token = others;
-	}
-}
-
-void State::advance() {
-	while (ch != EOF && Scanner_isWhitespace(ch)) { next(); }
-
-	constexpr int dot_dot { 1000 };
-
-	if (ch == EOF) { Scanner_token = Token_eof; return; }
-
-	if (Scanner_isLetter(ch)) {
-		value.clear();
-		while (Scanner_isLetter(ch) || Scanner_isDigit(ch)) { add_ch_to_value(); }
-		auto got { keywords.find(value) };
-		Scanner_token = got == keywords.end() ? Token_identifier : got->second;
-		return;
-	}
-
-	if (Scanner_isDigit(ch)) {
-		value.clear();
-		bool is_hex { false };
-		for (;;) {
-			if (Scanner_isDigit(ch)) {
-				add_ch_to_value();
-			} else if (ch >= 'A' && ch <= 'F') {
-				add_ch_to_value();
-				is_hex = true;
-			} else { break; }
+ModuleGraph build_module_graph(const std::vector<std::string>& paths) {
+	ModuleGraph graph;
+	auto count { paths.size() };
+	graph.imports.resize(count);
+	graph.dependents.resize(count);
+	std::map<std::string, std::size_t, std::less<>> by_name;
+	for (const auto& path : paths) {
+		try {
+			graph.headers.push_back(read_module_header(path));
 		}
-		if (ch == 'H') {
-			value = "0x" + value;
-			is_hex = true;
-			next();
-		} else if (ch == 'X') {
-			set_token(Token_charLiteral);
-			return;
-		} else if (is_hex) {
-			Scanner_token = Token_unknown;
-			return;
+		catch (const Error&) {
+			// convert() reports the broken module
+			graph.headers.emplace_back();
 		}
-		if (ch == '.') {
-			ch = in.get();
-			if (ch == '.') {
-				ch = dot_dot;
-				Scanner_token = Token_integerLiteral;
-				return;
+		by_name.emplace(graph.headers.back().name, graph.headers.size() - 1);
+	}
+	for (std::size_t i { 0 }; i < count; ++i) {
+		for (const auto& name : graph.headers[i].imports) {
+			auto got { by_name.find(name) };
+			if (got != by_name.end() && got->second != i) {
+				graph.imports[i].push_back(got->second);
+				graph.dependents[got->second].push_back(i);
 			}
-			value += '.';
-			if (is_hex) { set_token(Token_unknown); return; }
-			while (Scanner_isDigit(ch)) { add_ch_to_value(); }
-			if (ch == 'E') {
-				add_ch_to_value();
-				if (ch == '+' || ch == '-') { add_ch_to_value(); }
-				if (!Scanner_isDigit(ch)) {
-					Scanner_token = Token_unknown;
-					return;
-				}
-				while (Scanner_isDigit(ch)) { add_ch_to_value(); }
-			}
-			Scanner_token = Token_floatLiteral;
-			return;
 		}
-		Scanner_token = Token_integerLiteral;
-		return;
-	}
-
-	switch (ch) {
-		case '+': set_token(Token_plus); break;
-		case '-': set_token(Token_minus); break;
-		case '*': set_token(Token_star); break;
-		case '/': set_token(Token_slash); break;
-		case ')': set_token(Token_rightParenthesis); break;
-		case ',': set_token(Token_comma); break;
-		case ';': set_token(Token_semicolon); break;
-		case '=': set_token(Token_equals); break;
-		case '#': set_token(Token_notEquals); break;
-		case '|': set_token(Token_bar); break;
-		case '[': set_token(Token_leftBracket); break;
-		case ']': set_token(Token_rightBracket); break;
-		case '^': set_token(Token_ptr); break;
-		case '&': set_token(Token_andop); break;
-		case '~': set_token(Token_notop); break;
-		case '{': set_token(Token_leftBrace); break;
-		case '}': set_token(Token_rightBrace); break;
-		case '.': set_bi_char_token('.', Token_range, Token_period); break;
-		case dot_dot: set_token(Token_range); break;
-		case ':': set_bi_char_token('=', Token_assign, Token_colon); break;
-		case '<': set_bi_char_token('=', Token_lessOrEqual, Token_less); break;
-		case '>':
-			set_bi_char_token('=', Token_greaterOrEqual, Token_greater); break;
-		case '"':
-			next();
-			value.clear();
-			while (ch != EOF && ch != '"') { add_ch_to_value(); }
-			if (ch != '"') {
-				Scanner_token = Token_unknown;
-			} else {
-				set_token(Token_stringLiteral);
-			}
-			break;
-		case '(':
-			next();
-			if (ch == '*') {
-				do_comment();
-			} else {
-				Scanner_token = Token_leftParenthesis;
-			}
-			break;
-		default: set_token(Token_unknown);
 	}
-}
 
-void State::consume(const Token& tok) {
-	expect(tok);
-	advance();
-}
-
-void parse_module(State& state);
+	// Kahn's algorithm, taking ready modules in command line order
+	std::vector<std::size_t> missing(count);
+	for (std::size_t i { 0 }; i < count; ++i) { missing[i] = graph.imports[i].size(); }
+	std::vector<bool> placed(count, false);
+	while (graph.order.size() < count) {
+		std::size_t ready { 0 };
+		while (ready < count && (placed[ready] || missing[ready])) { ++ready; }
+		if (ready == count) { throw Error { describe_cycle(graph, placed) }; }
+		placed[ready] = true;
+		graph.order.push_back(ready);
+		for (auto dependent : graph.dependents[ready]) { --missing[dependent]; }
+	}
+	return graph;
+}
+
+// Result of one module translation; printed in command line order
+struct Translation {
+	std::string path;
+	std::ostringstream log;
+	std::string error;
+	std::string unity_code;
+	const std::set<std::string>* keep { nullptr };
+	bool has_init { true };
+	bool done { false };
+};
 
-void convert(const std::string& path) {
-	std::cout << "converting " << path << "\n";
-	if (path.size() < 4 || path.substr(path.size() - 4) != ".Mod") {
-		throw Error { "no mod file" };
+void run_translation(Translation& translation, const Options& options) {
+	try {
+		translation.has_init = convert(
+			translation.path, options, translation.log, translation.keep, translation.unity_code
+		);
 	}
-	auto base_path { path.substr(0, path.size() - 4) };
-	auto h_path { base_path + ".h" };
-	auto cxx_path { base_path + ".cpp" };
-	auto start_of_file { base_path.rfind('/') };
-	auto base {
-		start_of_file == std::string::npos ?
-			base_path : base_path.substr(start_of_file + 1)
-	};
-
-	std::ifstream mod_file { path.c_str() };
-	std::ofstream h_file { h_path.c_str() };
-	std::ofstream cxx_file { cxx_path.c_str() };
-
-	h_file << "#pragma once\n\n#include \"SYSTEM.h\"\n\n";
-	cxx_file << "#include \"" << base << ".h\"\n\n";
-	State state { base, mod_file, h_file, cxx_file };
-	parse_module(state);
-}
-
-void parse_import_list(State& state);
-void parse_declaration_sequence(State &state);
-void parse_statement_sequence(State& state);
-
-void parse_module(State& state) {
-	state.consume(Token_kwMODULE);
-	state.expect(Token_identifier);
-	auto module_name { state.value };
-	if (module_name != state.base) {
-		throw Error { "MODULE name doesn't match file name" };
-	}
-	state.advance();
-	state.consume(Token_semicolon);
-	state.cxx << "static void init_module_imports() {\n";
-
-	if (Scanner_token == Token_kwIMPORT) {
-		parse_import_list(state);
-	}
-	state.cxx << "}\n\n";
-
-	parse_declaration_sequence(state);
-	state.h << "void " << state.base << "_init_module();\n";
-	state.cxx << "void " << state.base << "_init_module() {\n";
-	state.indent(); state.cxx << "static bool already_run { false };\n";
-	state.indent(); state.cxx << "if (already_run) { return; }\n";
-	state.indent(); state.cxx << "already_run = true;\n";
-	state.indent(); state.cxx << "init_module_imports();\n";
-	if (Scanner_token == Token_kwBEGIN) {
-		state.advance();
-		parse_statement_sequence(state);
-	}
-	state.consume(Token_kwEND);
-	state.expect(Token_identifier);
-	if (module_name != state.value) {
-		throw Error { "MODULE names don't match" };
-	}
-	state.advance();
-	state.consume(Token_period);
-	state.expect(Token_eof);
-	state.cxx << "}\n";
-}
-
-void State::do_comment() {
-	throw Error { "comments not implemented" };
-}
-
-void parse_import(State& state);
-
-void parse_import_list(State& state) {
-	state.consume(Token_kwIMPORT);
-	parse_import(state);
-	while (Scanner_token == Token_comma) {
-		state.advance();
-		parse_import(state);
+	catch (const Error& err) {
+		translation.error = err.what();
 	}
-	state.consume(Token_semicolon);
-	state.h << "\n";
 }
 
-void parse_import(State& state) {
-	state.expect(Token_identifier);
-	auto name { state.value };
-	auto full_name { name };
-	state.advance();
-	if (Scanner_token == Token_assign) {
-		state.advance();
-		state.expect(Token_identifier);
-		full_name = state.value;
-		state.advance();
-	}
-	state.module_mapping[name] = full_name;
-	state.indent(); state.cxx << full_name << "_init_module();\n";
-	state.h << "#include \"" << full_name << ".h\"\n";
+bool report(const Translation& translation, std::ostream& out, std::ostream& err) {
+	out << translation.log.str();
+	if (translation.error.empty()) { return true; }
+	out.flush();
+	err << translation.error << "\n";
+	return false;
 }
 
-void parse_const_declaration(State& state);
-void parse_type_declaration(State& state);
-void parse_variable_declaration(State& state);
-void parse_procedure_declaration(State& state);
-
-void parse_declaration_sequence(State& state) {
-	if (Scanner_token == Token_kwCONST) {
-		state.advance();
-		while (Scanner_token == Token_identifier) {
-			parse_const_declaration(state);
-			state.consume(Token_semicolon);
+// Modules are translated after the modules they import, but reported in
+// command line order
+bool translate_all(
+	std::vector<Translation>& translations, const ModuleGraph& graph,
+	const Options& options, unsigned jobs, std::ostream& out, std::ostream& err
+) {
+	bool ok { true };
+	if (jobs <= 1) {
+		std::size_t reported { 0 };
+		for (auto index : graph.order) {
+			run_translation(translations[index], options);
+			translations[index].done = true;
+			while (reported < translations.size() && translations[reported].done) {
+				ok = report(translations[reported++], out, err) && ok;
+			}
 		}
-	}
-	if (Scanner_token == Token_kwTYPE) {
-		state.advance();
-		while (Scanner_token == Token_identifier) {
-			parse_type_declaration(state);
-			state.consume(Token_semicolon);
+		return ok;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::vector<std::size_t> missing(translations.size());
+	Pool pool { jobs };
+	std::function<void(std::size_t)> schedule;
+	schedule = [&](std::size_t index) {
+		pool.submit([&, index] {
+			run_translation(translations[index], options);
+			std::lock_guard lock { mutex };
+			translations[index].done = true;
+			for (auto dependent : graph.dependents[index]) {
+				if (--missing[dependent] == 0) { schedule(dependent); }
+			}
+			finished.notify_one();
+		});
+	};
+	{
+		std::lock_guard lock { mutex };
+		for (std::size_t i { 0 }; i < translations.size(); ++i) {
+			missing[i] = graph.imports[i].size();
 		}
-	}
-	if (Scanner_token == Token_kwVAR) {
-		state.advance();
-		while (Scanner_token == Token_identifier) {
-			parse_variable_declaration(state);
-			state.consume(Token_semicolon);
+		for (std::size_t i { 0 }; i < translations.size(); ++i) {
+			if (!missing[i]) { schedule(i); }
 		}
 	}
-
-	while (Scanner_token == Token_kwPROCEDURE) {
-		parse_procedure_declaration(state);
-		state.consume(Token_semicolon);
+	for (auto& translation : translations) {
+		{
+			std::unique_lock lock { mutex };
+			finished.wait(lock, [&] { return translation.done; });
+		}
+		ok = report(translation, out, err) && ok;
 	}
+	pool.wait();
+	return ok;
 }
 
-void parse_const_expression(State& state);
-std::string parse_ident_def(State& state);
-
-void parse_const_declaration(State& state) {
-	state.h << "constexpr auto ";
-	state.h << parse_ident_def(state);
-	state.consume(Token_equals);
-	state.h << " { ";
-	parse_const_expression(state);
-	state.h << " };\n";
+// Initializes all modules of a program in import order. Imported modules
+// that were not translated with the program initialize themselves and
+// their imports, they are called before the first module that imports
+// them. Their headers are added to includes, as are the headers of the
+// program's modules if include_program is set.
+void program_init(
+	const std::vector<Translation>& translations, const ModuleGraph& graph,
+	bool include_program, std::string& includes, std::string& calls
+) {
+	std::set<std::string> linked, called;
+	for (const auto& header : graph.headers) { linked.insert(header.name); }
+	for (auto index : graph.order) {
+		const auto& header { graph.headers[index] };
+		if (include_program) {
+			includes += "#include \"" + header.name + ".h\"\n";
+		}
+		for (const auto& imported : header.imports) {
+			if (imported == "SYSTEM" || linked.count(imported) ||
+				!called.insert(imported).second
+			) {
+				continue;
+			}
+			includes += "#include \"" + imported + ".h\"\n";
+			calls += "\t" + imported + "_init_module();\n";
+		}
+		if (translations[index].has_init) {
+			calls += "\t" + header.name + "_init_module();\n";
+		}
+	}
 }
 
-std::string parse_ident_def(State& state) {
-	state.expect(Token_identifier);
-	auto result { state.base + "_" + state.value };
-	state.advance();
-	if (Scanner_token == Token_star) {
-		state.advance();
+void write_link_file(
+	const std::string& path, const std::vector<Translation>& translations,
+	const ModuleGraph& graph, bool write_main
+) {
+	std::string includes, calls;
+	program_init(translations, graph, true, includes, calls);
+	std::string content { includes + "\nvoid oberon_init_all() noexcept;\n\nvoid oberon_init_all() noexcept {\n" + calls + "}\n" };
+	if (write_main) {
+		content += "\nint main() {\n\toberon_init_all();\n}\n";
 	}
-	return result;
+	write_if_changed(path, content);
 }
 
-std::string parse_expression(State& state);
-
-void parse_const_expression(State& state) {
-	state.h << parse_expression(state);
+// The whole program as one translation unit: everything but main() is
+// in an anonymous namespace, so the C++ compiler sees every call site
+// and may inline and drop procedures across modules
+void write_unity_file(
+	const std::string& path, const std::vector<Translation>& translations,
+	const ModuleGraph& graph
+) {
+	std::string includes, calls;
+	program_init(translations, graph, false, includes, calls);
+	std::string content { "#include \"SYSTEM.h\"\n" + includes + "\nnamespace {\n" };
+	for (auto index : graph.order) {
+		content += "\n// MODULE " + graph.headers[index].name + "\n\n";
+		content += translations[index].unity_code;
+	}
+	content += "\nvoid oberon_init_all() noexcept {\n" + calls + "}\n\n}\n";
+	content += "\nint main() {\n\toberon_init_all();\n}\n";
+	write_if_changed(path, content);
 }
 
-std::string parse_type(State& state);
-
-void parse_type_declaration(State& state) {
-	auto name { parse_ident_def(state) };
-	state.consume(Token_equals);
-	bool is_record { Scanner_token == Token_kwRECORD };
-	auto type { parse_type(state) };
-	if (is_record) {
-		state.h << "struct " << name << type;
-	} else {
-		state.h << "using " << name << " = " << type << ";\n";
+unsigned parse_jobs(const std::string& count) {
+	try {
+		std::size_t used { 0 };
+		auto jobs { std::stoul(count, &used) };
+		if (used == count.size()) {
+			return jobs ? jobs : std::max(std::thread::hardware_concurrency(), 1u);
+		}
 	}
+	catch (const std::logic_error&) { }
+	throw Error { "-j expects a number of jobs" };
 }
 
-std::string parse_ident_list(State& state);
-
-void parse_variable_declaration(State& state) {
-	auto idents { parse_ident_list(state) };
-	state.consume(Token_colon);
-	auto type { parse_type(state) };
-	state.h << "extern " << type << " " << idents << ";\n";
-	state.cxx << type << " " << idents << ";\n";
+std::string without_extension(const std::string& path) {
+	return path.substr(0, path.size() - 4);
 }
 
-std::string parse_ident_list(State& state) {
-	auto idents { parse_ident_def(state) };
-	while (Scanner_token == Token_comma) {
-		state.advance();
-		idents += ", ";
-		idents += parse_ident_def(state);
-	}
-	return idents;
+std::string sibling_path(const std::string& path, const std::string& name) {
+	auto start_of_file { path.rfind('/') };
+	return path.substr(0, start_of_file + 1) + name;
 }
 
-std::string parse_qual_ident(State& state);
-std::string parse_array_type(State& state);
-std::string parse_record_type(State& state);
-std::string parse_pointer_type(State& state);
-std::string parse_procedure_type(State& state);
-
-std::string parse_type(State& state) {
-	if (Scanner_token == Token_identifier) {
-		return parse_qual_ident(state);
-	} else if (Scanner_token == Token_kwARRAY) {
-		return parse_array_type(state);
-	} else if (Scanner_token == Token_kwRECORD) {
-		return parse_record_type(state);
-	} else if (Scanner_token == Token_kwPOINTER) {
-		return parse_pointer_type(state);
-	} else if (Scanner_token == Token_kwPROCEDURE) {
-		return parse_procedure_type(state);
+// Parses and folds a module to find the declarations it uses
+ModuleUses module_uses(const std::string& path, const Options& options) {
+	auto base_path { without_extension(path) };
+	auto start_of_file { base_path.rfind('/') };
+	auto base {
+		start_of_file == std::string::npos ?
+			base_path : base_path.substr(start_of_file + 1)
+	};
+	Source mod_file { path };
+	Interfaces interfaces { options.search_path, *options.interfaces };
+	auto dir { directory_of(path) };
+	Module module;
+	parse_module(base, mod_file, module);
+	fold_module(module, interfaces, dir);
+	return collect_uses(module);
+}
+
+// Whole program analysis for --strip: the declarations that the module
+// bodies reach. Returns false if a module cannot be parsed, its
+// translation reports the error.
+bool program_uses(
+	const std::vector<Translation>& translations, const Options& options, unsigned jobs,
+	std::vector<ModuleUses>& uses
+) {
+	uses.resize(translations.size());
+	std::vector<char> parsed(translations.size(), false);
+	auto analyze = [&](std::size_t index) {
+		try {
+			uses[index] = module_uses(translations[index].path, options);
+			parsed[index] = true;
+		}
+		catch (const Error&) { }
+	};
+	if (jobs <= 1) {
+		for (std::size_t i { 0 }; i < translations.size(); ++i) { analyze(i); }
 	} else {
-		throw Error { "type expected" };
+		Pool pool { jobs };
+		for (std::size_t i { 0 }; i < translations.size(); ++i) {
+			pool.submit([&, i] { analyze(i); });
+		}
+		pool.wait();
+	}
+	for (auto ok : parsed) {
+		if (!ok) { return false; }
 	}
+	return true;
 }
 
-std::string parse_array_type(State& state) {
-	throw Error { "parse_array_type not implemented" };
+// Build rules for the translation step. Each module is retranslated when
+// its source or a file listed in its depfile changes; the generated
+// headers of imported modules have to exist before it is translated.
+void write_deps(
+	std::ostream& out, const std::vector<std::string>& paths,
+	const ModuleGraph& graph, const std::string& format
+) {
+	bool ninja { format == "ninja" };
+	if (!ninja && format != "make") {
+		throw Error { "--deps expects make or ninja" };
+	}
+	out << "# generated by o2c++ --deps " << format << "\n\n";
+	if (ninja) {
+		out << "rule o2cxx\n" <<
+			"  command = o2c++ --depfile $in\n" <<
+			"  description = O2C++ $in\n" <<
+			"  depfile = $depfile\n" <<
+			"  deps = gcc\n" <<
+			"  restat = 1\n\n";
+	} else {
+		out << "O2CXX ?= o2c++\n\n";
+	}
+	for (auto index : graph.order) {
+		const auto& path { paths[index] };
+		auto base_path { without_extension(path) };
+		std::string outputs { base_path + ".h " + base_path + ".cpp" };
+		std::string imported;
+		for (auto import : graph.imports[index]) {
+			imported += " " + without_extension(paths[import]) + ".h";
+		}
+		if (ninja) {
+			out << "build " << outputs << ": o2cxx " << path;
+			if (!imported.empty()) { out << " ||" << imported; }
+			out << "\n  depfile = " << base_path << ".d\n\n";
+		} else {
+			out << outputs << " &: " << path;
+			if (!imported.empty()) { out << " |" << imported; }
+			out << "\n\t$(O2CXX) --depfile " << path << "\n" <<
+				"-include " << base_path << ".d\n\n";
+		}
+	}
 }
 
-std::string parse_base_type(State& state);
-std::string parse_field_list_sequence(State& state);
-
-std::string parse_record_type(State& state) {
-	std::string result;
-	state.consume(Token_kwRECORD);
-	if (Scanner_token == Token_leftParenthesis) {
-		state.advance();
-		result = ": " + parse_base_type(state);
-		state.consume(Token_rightParenthesis);
+// Translates the modules given by paths and writes the link or unity file
+bool translate_program(
+	std::vector<std::string> paths, const Options& options, unsigned jobs,
+	std::ostream& out, std::ostream& err
+) {
+	ModuleGraph graph;
+	try {
+		graph = build_module_graph(paths);
+	}
+	catch (const Error& error) {
+		err << error.what() << "\n";
+		return false;
+	}
+	std::vector<Translation> translations(paths.size());
+	for (std::size_t i { 0 }; i < paths.size(); ++i) {
+		translations[i].path = std::move(paths[i]);
+	}
+	std::vector<ModuleUses> uses;
+	std::set<std::string> keep;
+	bool strip { options.strip && program_uses(translations, options, jobs, uses) };
+	if (strip) {
+		keep = reachable(uses);
+		for (auto& translation : translations) { translation.keep = &keep; }
+	}
+	if (!translate_all(translations, graph, options, jobs, out, err)) { return false; }
+	if (strip) {
+		for (const auto& module : uses) {
+			for (const auto& declaration : module.declarations) {
+				if (!keep.count(declaration.first)) {
+					out << "dropped " << declaration.first << "\n";
+				}
+			}
+		}
 	}
-	result += " {\n";
-	if (Scanner_token != Token_kwEND) {
-		result += parse_field_list_sequence(state);
+	if (!options.link_path.empty()) {
+		write_link_file(options.link_path, translations, graph, options.write_main);
 	}
-	result += "};\n";
-	state.consume(Token_kwEND);
-	return result;
-}
-
-std::string parse_base_type(State& state) {
-	throw Error { "parse_base_type not implemented" };
-}
-
-std::string parse_field_list_sequence(State& state) {
-	throw Error { "parse_field_list_sequence not implemented" };
-}
-
-std::string parse_pointer_type(State& state) {
-	throw Error { "parse_pointer_type not implemented" };
-}
-
-std::string parse_procedure_type(State& state) {
-	throw Error { "parse_procedure_type not implemented" };
-}
-
-void parse_formal_parameters(State& state);
-void parse_procedure_body(State& state);
-
-void parse_procedure_declaration(State& state) {
-	state.consume(Token_kwPROCEDURE);
-	auto name { parse_ident_def(state) };
-
-	state.h << "auto " << name;
-	state.cxx << "auto " << name;
-	parse_formal_parameters(state);
-
-	state.consume(Token_semicolon);
-	state.h << ";\n";
-	state.cxx << " {\n";
-
-	parse_procedure_body(state);
-	state.expect(Token_identifier);
-	if (state.base + "_" + state.value != name) {
-		throw Error { "PROCEDURE names don't match" };
+	if (!options.unity_path.empty()) {
+		write_unity_file(options.unity_path, translations, graph);
 	}
-	state.advance();
-	state.cxx <<"}\n";
+	return true;
 }
 
-void parse_formal_parameter_section(State& state);
-
-void parse_formal_parameters(State& state) {
-	state.consume(Token_leftParenthesis);
-	state.h << "(";
-	state.cxx << "(";
-	if (Scanner_token != Token_rightParenthesis) {
-		parse_formal_parameter_section(state);
-		while (Scanner_token == Token_semicolon) {
-			state.advance();
-			parse_formal_parameter_section(state);
-		}
+std::vector<std::string> string_list(const Json* list, const char* name) {
+	std::vector<std::string> result;
+	if (!list) { return result; }
+	if (list->kind != Json::Kind::array) {
+		throw Error { std::string { name } + " expects an array of strings" };
 	}
-	state.consume(Token_rightParenthesis);
-	state.h << ") -> ";
-	state.cxx << ") -> ";
-	if (Scanner_token == Token_colon) {
-		state.advance();
-		auto type { parse_qual_ident(state) };
-		state.h << type;
-		state.cxx << type;
-	} else {
-		state.h << "void";
-		state.cxx << "void";
+	for (const auto& item : list->items) {
+		if (item.kind != Json::Kind::string) {
+			throw Error { std::string { name } + " expects an array of strings" };
+		}
+		result.push_back(item.string);
 	}
+	return result;
 }
 
-void parse_formal_type(State& state);
-
-void parse_formal_parameter_section(State& state) {
-	bool reference { false };
-	if (Scanner_token == Token_kwVAR) { reference = true; state.advance(); }
-	std::vector<std::string> names;
-	state.expect(Token_identifier);
-	names.push_back(state.value);
-	state.advance();
-	while (Scanner_token == Token_comma) {
-		state.advance();
-		state.expect(Token_identifier);
-		names.push_back(state.value);
-		state.advance();
+// One request of the server protocol, like
+//	{"id": 1, "files": ["a/Hello.Mod"], "include": ["lib"], "jobs": 4,
+//		"link": "a/init.cpp", "main": true, "cache": false}
+// or {"id": 2, "shutdown": true}; "unity": "a/program.cpp" may take the
+// place of link and main, "strip": true needs one of them,
+// "unchecked": true leaves out the index checks, "report_checks": true
+// lists those that remain and "simd": true marks vectorizable loops. The
+// answer echoes the id and holds the translation messages:
+//	{"id": 1, "ok": true, "output": "converting a/Hello.Mod\n", "errors": ""}
+std::string handle_request(
+	const Json& request, const Options& defaults, unsigned default_jobs, bool& stop
+) {
+	if (request.kind != Json::Kind::object) { throw Error { "request must be an object" }; }
+	std::string answer { "{" };
+	if (auto id { request.member("id") }) {
+		answer += "\"id\":";
+		write_json(answer, *id);
+		answer += ",";
 	}
-
-	state.consume(Token_colon);
-	parse_formal_type(state);
-	if (reference) {
-		state.h << "&";
-		state.cxx << "&";
+	if (auto shutdown { request.member("shutdown") }; shutdown && shutdown->boolean) {
+		stop = true;
+		return answer + "\"ok\":true}";
 	}
 
-	const char* prefix { " " };
-	for (const auto& name : names) {
-		state.h << prefix << state.base << "_" << name;
-		state.cxx << prefix << state.base << "_" << name;
-		prefix = ", ";
+	auto options { defaults };
+	auto jobs { default_jobs };
+	auto paths { string_list(request.member("files"), "files") };
+	if (paths.empty()) { throw Error { "files expects at least one module" }; }
+	for (auto& dir : string_list(request.member("include"), "include")) {
+		options.search_path.push_back(std::move(dir));
 	}
-}
-
-void parse_formal_type(State& state) {
-	int arrays { 0 };
-	while (Scanner_token == Token_kwARRAY) {
-		state.advance();
-		state.consume(Token_kwOF);
-		++arrays;
+	if (auto link { request.member("link") }) {
+		if (link->kind != Json::Kind::string) { throw Error { "link expects a file name" }; }
+		options.link_path = link->string;
 	}
-	auto type { parse_qual_ident(state) };
-	state.h << type;
-	state.cxx << type;
-	for (; arrays; --arrays) {
-		state.h << '*';
-		state.cxx << '*';
+	if (auto main { request.member("main") }) {
+		options.write_main = main->boolean;
 	}
-}
-
-void parse_procedure_body(State& state) {
-	parse_declaration_sequence(state);
-	if (Scanner_token == Token_kwBEGIN) {
-		state.advance();
-		parse_statement_sequence(state);
+	if (auto unity { request.member("unity") }) {
+		if (unity->kind != Json::Kind::string) { throw Error { "unity expects a file name" }; }
+		options.unity_path = unity->string;
 	}
-	if (Scanner_token == Token_kwRETURN) {
-		state.advance();
-		state.indent(); state.cxx << "return " << parse_expression(state) << ";\n";
+	if (options.write_main && options.link_path.empty()) {
+		throw Error { "main needs link" };
 	}
-	state.consume(Token_kwEND);
-}
-
-void parse_statement(State& state);
-
-void parse_statement_sequence(State& state) {
-	parse_statement(state);
-	while (Scanner_token == Token_semicolon) {
-		state.advance();
-		parse_statement(state);
+	if (!options.unity_path.empty() && !options.link_path.empty()) {
+		throw Error { "unity excludes link" };
 	}
-}
-
-void parse_assignment_or_procedure_call(State& state);
-void parse_if_statement(State& state);
-void parse_case_statement();
-void parse_while_statement();
-void parse_repeat_statement();
-void parse_for_statement();
-
-void parse_statement(State& state) {
-	if (Scanner_token == Token_identifier) {
-		parse_assignment_or_procedure_call(state);
-	} else if (Scanner_token == Token_kwIF) {
-		parse_if_statement(state);
-	} else if (Scanner_token == Token_kwCASE) {
-		parse_case_statement();
-	} else if (Scanner_token == Token_kwWHILE) {
-		parse_while_statement();
-	} else if (Scanner_token == Token_kwREPEAT) {
-		parse_repeat_statement();
-	} else if (Scanner_token == Token_kwFOR) {
-		parse_for_statement();
+	if (auto strip { request.member("strip") }) {
+		options.strip = strip->boolean;
 	}
-}
-
-std::string parse_designator(State& state);
-std::string parse_actual_parameters(State& state);
-
-void parse_assignment_or_procedure_call(State& state) {
-	state.indent(); state.cxx << parse_designator(state);
-	if (Scanner_token == Token_assign) {
-		state.advance();
-		state.cxx << " = " << parse_expression(state) << ";\n";
-	} else {
-		if (Scanner_token == Token_leftParenthesis) {
-			state.cxx << "(";
-			state.cxx << parse_actual_parameters(state);
-			state.cxx << ");\n";
-		} else { state.cxx << "();\n"; }
+	if (options.strip && options.link_path.empty() && options.unity_path.empty()) {
+		throw Error { "strip needs link or unity" };
 	}
-}
-
-std::string parse_expression_list(State& state, const char* separator);
-
-std::string parse_designator(State& state) {
-	auto qual_ident { parse_qual_ident(state) };
-
-	for (;;) {
-		if (Scanner_token == Token_period) {
-			state.advance();
-			state.expect(Token_identifier);
-			qual_ident = "(" + qual_ident + ")." + state.value;
-			state.advance();
-		} else if (Scanner_token == Token_leftBracket) {
-			state.advance();
-			qual_ident = "(" + qual_ident + ")[";
-			qual_ident += parse_expression_list(state, "][");
-			state.consume(Token_rightBracket);
-			qual_ident += "]";
-		} else if (Scanner_token == Token_ptr) {
-			qual_ident = "*(" + qual_ident + ")";
-			state.advance();
-			/* TODO: Implement cast
-		} else if (token::is(token::left_parenthesis)) {
-			advance();
-			auto type { type::Type::as_type(parse_qual_ident()) };
-			if (!type) { diag::report(diag::err_type_expected); }
-			consume(token::right_parenthesis);
-			expression = expr::Unary::create(
-				type, token::left_parenthesis, expression
-			);
-			 */
-		} else { break; }
-	}
-	return qual_ident;
-}
-
-std::string parse_qual_ident(State& state) {
-	state.expect(Token_identifier);
-	auto name { state.value };
-	state.advance();
-	auto module { state.module_mapping.find(name) };
-	if (module != state.module_mapping.end()) {
-		if (Scanner_token == Token_period) {
-			state.advance();
-			state.expect(Token_identifier);
-			name = state.module_mapping[name] + "_" + state.value;
-			state.advance();
-		} else { throw Error { ". after module expected" }; }
-	} else if (name == "INTEGER") {
-		name = "SYSTEM_INTEGER";
-	} else if (name == "CHAR") {
-		name = "SYSTEM_CHAR";
-	} else if (name == "BOOLEAN") {
-		name = "SYSTEM_BOOLEAN";
-	} else {
-		name = state.base + "_" + name;
+	if (auto unchecked { request.member("unchecked") }) {
+		options.checked = !unchecked->boolean;
 	}
-	return name;
-}
-
-std::string parse_expression_list(State& state, const char* separator) {
-	auto result { parse_expression(state) };
-	while (Scanner_token == Token_comma) {
-		state.advance();
-		result += separator;
-		result += parse_expression(state);
+	if (auto report { request.member("report_checks") }) {
+		options.report_checks = report->boolean;
 	}
-	return result;
-}
-
-std::string parse_simple_expression(State& state);
-
-std::string parse_expression(State& state) {
-	auto result { parse_simple_expression(state) };
-	for (;;) {
-		switch (Scanner_token) {
-			case Token_equals: result += " == "; break;
-			case Token_notEquals: result += " != "; break;
-			case Token_less: result += " < "; break;
-			case Token_lessOrEqual: result += " <= "; break;
-			case Token_greater: result += " > "; break;
-			case Token_greaterOrEqual: result += " >= "; break;
-			// TODO: Token::IN
-			// TODO: Token::IS
-			default: return result;
-		}
-		state.advance();
-		result += parse_simple_expression(state);
+	if (auto simd { request.member("simd") }) {
+		options.simd = simd->boolean;
 	}
-}
-
-std::string parse_term(State& state);
-
-std::string parse_simple_expression(State& state) {
-	std::string result;
-	if (Scanner_token == Token_plus) {
-		result += "+"; state.advance();
-	} else if (Scanner_token == Token_minus) {
-		result += "-"; state.advance();
+	if (auto cache { request.member("cache") }) {
+		options.use_cache = cache->boolean;
 	}
-	result += parse_term(state);
-
-	for (;;) {
-		switch (Scanner_token) {
-			case Token_plus: result += " + "; break;
-			case Token_minus: result += " - "; break;
-			case Token_kwOR: result += " || "; break;
-			default: return result;
+	if (auto count { request.member("jobs") }) {
+		if (count->kind != Json::Kind::number || count->number < 0) {
+			throw Error { "jobs expects a number" };
 		}
-		state.advance();
-		result += parse_term(state);
+		jobs = count->number ? static_cast<unsigned>(count->number) :
+			std::max(std::thread::hardware_concurrency(), 1u);
 	}
-}
-
-std::string parse_factor(State& state);
 
-std::string parse_term(State& state) {
-	auto result { parse_factor(state) };
-
-	for (;;) {
-		char* postfix = "";
-		switch (Scanner_token) {
-			case Token_star: result += " * "; break;
-			case Token_slash: result = "static_cast<double>(" + result + ") / "; break;
-			case Token_kwDIV: result += "static_cast<int>(" + result + " / "; postfix = ")"; break;
-			case Token_kwMOD: result += " % "; break;
-			case Token_andop: result += " && "; break;
-			default: return result;
-		}
-		state.advance();
-		result += parse_factor(state);
-		result += postfix;
-	}
+	std::ostringstream out, err;
+	bool ok { translate_program(std::move(paths), options, jobs, out, err) };
+	answer += ok ? "\"ok\":true" : "\"ok\":false";
+	answer += ",\"output\":";
+	write_json_string(answer, out.str());
+	answer += ",\"errors\":";
+	write_json_string(answer, err.str());
+	return answer + "}";
 }
 
-std::string parse_set();
-
-std::string parse_factor(State& state) {
-	switch (Scanner_token) {
-		case Token_integerLiteral:
-		case Token_floatLiteral: {
-			auto result { state.value };
-			state.advance();
-			return result;
+int main(int argc, const char** argv) {
+	unsigned jobs { 1 };
+	InterfaceStore interfaces;
+	Options options;
+	options.interfaces = &interfaces;
+	bool serve { false };
+	std::string socket_path;
+	std::vector<std::string> paths;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg { argv[i] };
+			if (arg.rfind("-j", 0) == 0) {
+				if (arg.size() > 2) {
+					jobs = parse_jobs(arg.substr(2));
+				} else if (i + 1 < argc) {
+					jobs = parse_jobs(argv[++i]);
+				} else { throw Error { "-j expects a number of jobs" }; }
+			} else if (arg == "--no-cache") {
+				options.use_cache = false;
+			} else if (arg == "--cache") {
+				if (i + 1 >= argc) { throw Error { "--cache expects a directory" }; }
+				options.cache_dir = argv[++i];
+			} else if (arg == "--depfile") {
+				options.write_depfile = true;
+			} else if (arg == "-I") {
+				if (i + 1 >= argc) { throw Error { "-I expects a directory" }; }
+				options.search_path.emplace_back(argv[++i]);
+			} else if (arg == "--link") {
+				if (i + 1 >= argc) { throw Error { "--link expects a file name" }; }
+				options.link_path = argv[++i];
+			} else if (arg == "--unity") {
+				if (i + 1 >= argc) { throw Error { "--unity expects a file name" }; }
+				options.unity_path = argv[++i];
+			} else if (arg == "--unchecked") {
+				options.checked = false;
+			} else if (arg == "--report-checks") {
+				options.report_checks = true;
+			} else if (arg == "--simd") {
+				options.simd = true;
+			} else if (arg == "--strip") {
+				options.strip = true;
+			} else if (arg == "--main") {
+				options.write_main = true;
+			} else if (arg == "--serve") {
+				serve = true;
+			} else if (arg == "--socket") {
+				if (i + 1 >= argc) { throw Error { "--socket expects a path" }; }
+				socket_path = argv[++i];
+			} else if (arg == "--deps") {
+				if (i + 1 >= argc) { throw Error { "--deps expects make or ninja" }; }
+				options.deps_format = argv[++i];
+			} else {
+				paths.push_back(std::move(arg));
+			}
 		}
-		case Token_stringLiteral: {
-			auto result { "Oberon_String { \"" + state.value + "\" }" };
-			state.advance();
-			return result;
+		if (options.write_main && options.link_path.empty()) {
+			throw Error { "--main needs --link" };
 		}
-		case Token_charLiteral: {
-			auto result { "'\\x" + state.value + "'" };
-			state.advance();
-			return result;
+		if (!options.unity_path.empty() && !options.link_path.empty()) {
+			throw Error { "--unity excludes --link" };
 		}
-		case Token_kwNIL:
-			state.advance();
-			return "nullptr";
-		case Token_kwTRUE:
-			state.advance();
-			return "true";
-		case Token_kwFALSE:
-			state.advance();
-			return "false";
-		case Token_leftBrace:
-			return parse_set();
-		case Token_identifier: {
-			auto result { parse_designator(state) };
-			if (Scanner_token == Token_leftParenthesis) {
-				result += "(";
-				result += parse_actual_parameters(state);
-				result += ")";
-			}
-			return result;
+		if (options.strip && options.link_path.empty() && options.unity_path.empty()) {
+			throw Error { "--strip needs --link or --unity" };
 		}
-		case Token_leftParenthesis: {
-			state.advance();
-			auto inner { parse_expression(state) };
-			state.consume(Token_rightParenthesis);
-			return "(" + inner + ")";
+
+		// the server keeps the interfaces of imported modules between
+		// requests
+		auto handler = [&](const Json& request, bool& stop) {
+			return handle_request(request, options, jobs, stop);
+		};
+		if (!socket_path.empty()) {
+			serve_socket(socket_path, handler);
+			return EXIT_SUCCESS;
 		}
-		case Token_notop: {
-			state.advance();
-			auto factor { parse_expression(state) };
-			return "!(" + factor + ")";
+		if (serve) {
+			serve_stream(std::cin, std::cout, handler);
+			return EXIT_SUCCESS;
 		}
-		default: throw Error { "factor expected "};
-	}
-}
 
-std::string parse_set() {
-	throw Error { "parse_set not implemented" };
-}
-
-std::string parse_actual_parameters(State& state) {
-	std::string result;
-	state.consume(Token_leftParenthesis);
-	if (Scanner_token != Token_rightParenthesis) {
-		result = parse_expression_list(state, ", ");
+		if (!options.deps_format.empty()) {
+			auto graph { build_module_graph(paths) };
+			write_deps(std::cout, paths, graph, options.deps_format);
+			return EXIT_SUCCESS;
+		}
 	}
-	state.consume(Token_rightParenthesis);
-	return result;
-}
-
-void parse_if_statement(State& state) {
-	state.consume(Token_kwIF);
-	state.indent(); state.cxx << "if (" << parse_expression(state) << ") {\n";
-	state.consume(Token_kwTHEN);
-	++state.level;
-	parse_statement_sequence(state);
-	--state.level;
-	while (Scanner_token == Token_kwELSIF) {
-		state.advance();
-		state.indent(); state.cxx << "} else if (" << parse_expression(state) << ") {\n";
-		state.consume(Token_kwTHEN);
-		++state.level;
-		parse_statement_sequence(state);
-		--state.level;
-	}
-	if (Scanner_token == Token_kwELSE) {
-		state.advance();
-		state.indent(); state.cxx << "} else {\n";
-		++state.level;
-		parse_statement_sequence(state);
-		--state.level;
-	}
-	state.consume(Token_kwEND);
-	state.indent(); state.cxx << "}\n";
-}
-
-void parse_case_statement() {
-	throw Error { "parse_case_statement not implemented" };
+	catch (const Error& err) {
+		std::cerr << err.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return translate_program(std::move(paths), options, jobs, std::cout, std::cerr) ?
+		EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-void parse_while_statement() {
-	throw Error { "parse_while_statement not implemented" };
-}
+bool convert(
+	const std::string& path, const Options& options, std::ostream& log,
+	const std::set<std::string>* keep, std::string& unity_code
+) {
+	log << "converting " << path;
+	if (path.size() < 4 || path.substr(path.size() - 4) != ".Mod") {
+		throw Error { "no mod file" };
+	}
+	auto base_path { path.substr(0, path.size() - 4) };
+	auto h_path { base_path + ".h" };
+	auto cxx_path { base_path + ".cpp" };
+	auto start_of_file { base_path.rfind('/') };
+	auto base {
+		start_of_file == std::string::npos ?
+			base_path : base_path.substr(start_of_file + 1)
+	};
 
-void parse_repeat_statement() {
-	throw Error { "parse_repeat_statement not implemented" };
-}
+	Source mod_file { path };
+	Cache cache {
+		!options.cache_dir.empty() ? options.cache_dir :
+			base_path.substr(0, start_of_file + 1) + ".o2c++-cache"
+	};
+	// the output depends on the interfaces of the imported modules, but
+	// not on their procedure bodies
+	Interfaces interfaces { options.search_path, *options.interfaces };
+	auto dir { directory_of(path) };
+	auto imports { read_module_header(path).imports };
+	Hash key;
+	key.add(translator_version).add(base).add(mod_file.text());
+	auto mode {
+		!options.unity_path.empty() ? EmitMode::unity :
+			!options.link_path.empty() ? EmitMode::linked : EmitMode::modular
+	};
+	key.add(mode == EmitMode::unity ? "unity" : mode == EmitMode::linked ? "linked" : "modular");
+	key.add(options.checked ? "checked" : "unchecked");
+	key.add(options.simd ? "simd" : "");
+	for (const auto& name : imports) {
+		auto interface { name == "SYSTEM" ? nullptr : interfaces.find(name, dir) };
+		key.add(name).add(interface ? std::to_string(interface->fingerprint) : "");
+	}
+	if (keep) {
+		// the declarations of the module that the program reaches
+		auto prefix { base + "." };
+		for (auto it { keep->lower_bound(prefix) };
+			it != keep->end() && it->compare(0, prefix.size(), prefix) == 0; ++it
+		) {
+			key.add(*it);
+		}
+		key.add("strip");
+	}
 
-void parse_for_statement() {
-	throw Error { "parse_for_statement not implemented" };
+	std::string h, cxx, smb;
+	// the report needs the analysis, so it does not come from the cache
+	if (options.use_cache && !options.report_checks && cache.load(key, h, cxx, smb)) {
+		log << " (cached)\n";
+	} else {
+		log << "\n";
+		Module module;
+		parse_module(base, mod_file, module);
+		fold_module(module, interfaces, dir);
+		auto imported { interfaces.resolve(module, dir) };
+		std::string checks;
+		emit_module(
+			module, imported, h, cxx,
+			{ mode, options.checked, options.report_checks ? &checks : nullptr, options.simd }, keep
+		);
+		log << checks;
+		smb = write_symbols(module, Hash { }.add(mod_file.text()).value(), imported);
+		if (options.use_cache) { cache.store(key, h, cxx, smb); }
+	}
+	write_if_changed(base_path + ".smb", smb);
+	if (mode == EmitMode::unity) {
+		unity_code = h + cxx;
+	} else {
+		write_if_changed(h_path, h);
+		write_if_changed(cxx_path, cxx);
+	}
+	if (options.write_depfile && mode != EmitMode::unity) {
+		auto import_sources { interfaces.import_sources(imports, dir) };
+		auto depfile { h_path + " " + cxx_path + ": " + path };
+		for (const auto& import_path : import_sources) {
+			depfile += " " + import_path;
+		}
+		write_if_changed(base_path + ".d", depfile + "\n");
+	}
+	// the header tells for cached translations, too
+	return h.find("void " + base + "_init_module() noexcept;") != std::string::npos;
 }
-
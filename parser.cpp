@@ -0,0 +1,1016 @@
+#include "parser.h"
+
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "Token.h"
+#include "chars.h"
+#include "keywords.h"
+
+using Error = std::runtime_error;
+
+struct State {
+	const std::string base;
+	const Source& in;
+	Module& module;
+	const char* pos;
+	const char* const end;
+
+	Token token { Token_unknown };
+	const char* token_start { nullptr };
+	std::string_view value { };
+	std::vector<Import> imports;
+	const Name system;
+
+	void set_token(const Token& tok);
+	void set_bi_char_token(char trigger, const Token& with_trigger, const Token& others);
+	void do_comment();
+
+	void advance();
+
+	State(std::string base, const Source& in, Module& module):
+		base { std::move(base) }, in { in }, module { module },
+		pos { in.begin() }, end { in.end() },
+		system { module.names.intern("SYSTEM") }
+	{ advance(); }
+
+	void expect(const Token& tok) const;
+	void consume(const Token& tok);
+
+	Name name() { return module.names.intern(value); }
+	Position position() const {
+		return static_cast<Position>(token_start - in.begin());
+	}
+	bool is_module(const Name& name) const {
+		if (name == system) { return true; }
+		for (const auto& import : imports) {
+			if (import.alias == name) { return true; }
+		}
+		return false;
+	}
+
+	template<typename T, typename... Args>
+	T* make(Args&&... args) {
+		return module.arena.make<T>(std::forward<Args>(args)...);
+	}
+};
+
+std::string token_name(const Token& token, std::string_view value) {
+	const std::string text { value };
+	switch (token) {
+		case Token_unknown: return "unknown";
+		case Token_eof: return "eof";
+		case Token_identifier:	return "identifier " + text;
+		case Token_integerLiteral: return "integer " + text;
+		case Token_floatLiteral: return "float " + text;
+		case Token_stringLiteral: return "\"" + text + "\"";
+		case Token_charLiteral: return "'\\x" + text + "'";
+		case Token_plus: return "+";
+		case Token_minus: return "-";
+		case Token_star: return "*";
+		case Token_slash: return "/";
+		case Token_leftParenthesis: return "(";
+		case Token_rightParenthesis: return ")";
+		case Token_semicolon: return ";";
+		case Token_period: return ".";
+		case Token_comma: return ",";
+		case Token_colon: return ":";
+		case Token_assign: return ":=";
+		case Token_equals: return "=";
+		case Token_bar: return "|";
+		case Token_notEquals: return "#";
+		case Token_leftBracket: return "[";
+		case Token_rightBracket: return "]";
+		case Token_ptr: return "^";
+		case Token_andop: return "&";
+		case Token_notop: return "~";
+		case Token_leftBrace: return "{";
+		case Token_rightBrace: return "}";
+		case Token_less: return "<";
+		case Token_lessOrEqual: return "<=";
+		case Token_greater: return ">";
+		case Token_greaterOrEqual: return ">=";
+		case Token_range: return "..";
+		case Token_kwARRAY: return "ARRAY";
+		case Token_kwBEGIN: return "BEGIN";
+		case Token_kwBY: return "BY";
+		case Token_kwCASE: return "CASE";
+		case Token_kwCONST: return "CONST";
+		case Token_kwDIV: return "DIV";
+		case Token_kwDO: return "DO";
+		case Token_kwEND: return "END";
+		case Token_kwELSE: return "ELSE";
+		case Token_kwELSIF: return "ELSIF";
+		case Token_kwFALSE: return "FALSE";
+		case Token_kwFOR: return "FOR";
+		case Token_kwIF: return "IF";
+		case Token_kwIMPORT: return "IMPORT";
+		case Token_kwIN: return "IN";
+		case Token_kwIS: return "IS";
+		case Token_kwMOD: return "MOD";
+		case Token_kwMODULE: return "MODULE";
+		case Token_kwNIL: return "NIL";
+		case Token_kwOF: return "OF";
+		case Token_kwOR: return "OR";
+		case Token_kwPOINTER: return "POINTER";
+		case Token_kwPROCEDURE: return "PROCEDURE";
+		case Token_kwRECORD: return "RECORD";
+		case Token_kwREPEAT: return "REPEAT";
+		case Token_kwRETURN: return "RETURN";
+		case Token_kwTHEN: return "THEN";
+		case Token_kwTO: return "TO";
+		case Token_kwTRUE: return "TRUE";
+		case Token_kwTYPE: return "TYPE";
+		case Token_kwUNTIL: return "UNTIL";
+		case Token_kwVAR: return "VAR";
+		case Token_kwWHILE: return "WHILE";
+		default: return "??";
+	}
+}
+
+void State::expect(const Token& tok) const {
+	if (tok != token) {
+		throw Error {
+			"wrong token " + token_name(token, value) +
+			" (expected " + token_name(tok, "") + ")"
+		};
+	}
+}
+
+void State::set_token(const Token& tok) { token = tok; ++pos; }
+
+void State::set_bi_char_token(
+	char trigger, const Token& with_trigger, const Token& others
+) {
+	++pos;
+	if (pos != end && *pos == trigger) {
+		set_token(with_trigger);
+	} else {
+		token = others;
+	}
+}
+
+void State::advance() {
+	if (pos != end && is_whitespace(*pos)) { pos = skip_whitespace(pos + 1, end); }
+
+	token_start = pos;
+	if (pos == end) { token = Token_eof; return; }
+
+	const char* start { pos };
+
+	if (is_letter(*pos)) {
+		pos = skip_ident_chars(pos + 1, end);
+		value = { start, static_cast<std::size_t>(pos - start) };
+		token = keyword_token(value);
+		return;
+	}
+
+	if (is_digit(*pos)) {
+		bool is_hex { false };
+		for (; pos != end; ++pos) {
+			if (is_hex_letter(*pos)) {
+				is_hex = true;
+			} else if (!is_digit(*pos)) { break; }
+		}
+		value = { start, static_cast<std::size_t>(pos - start) };
+		if (pos != end && *pos == 'H') {
+			// keep the suffix in the token text, parse_factor rewrites it
+			++pos;
+			value = { start, static_cast<std::size_t>(pos - start) };
+			token = Token_integerLiteral;
+			return;
+		} else if (pos != end && *pos == 'X') {
+			set_token(Token_charLiteral);
+			return;
+		} else if (is_hex) {
+			token = Token_unknown;
+			return;
+		}
+		if (pos != end && *pos == '.') {
+			if (pos + 1 != end && pos[1] == '.') {
+				token = Token_integerLiteral;
+				return;
+			}
+			++pos;
+			while (pos != end && is_digit(*pos)) { ++pos; }
+			if (pos != end && *pos == 'E') {
+				++pos;
+				if (pos != end && (*pos == '+' || *pos == '-')) { ++pos; }
+				if (pos == end || !is_digit(*pos)) {
+					token = Token_unknown;
+					return;
+				}
+				while (pos != end && is_digit(*pos)) { ++pos; }
+			}
+			value = { start, static_cast<std::size_t>(pos - start) };
+			token = Token_floatLiteral;
+			return;
+		}
+		token = Token_integerLiteral;
+		return;
+	}
+
+	switch (*pos) {
+		case '+': set_token(Token_plus); break;
+		case '-': set_token(Token_minus); break;
+		case '*': set_token(Token_star); break;
+		case '/': set_token(Token_slash); break;
+		case ')': set_token(Token_rightParenthesis); break;
+		case ',': set_token(Token_comma); break;
+		case ';': set_token(Token_semicolon); break;
+		case '=': set_token(Token_equals); break;
+		case '#': set_token(Token_notEquals); break;
+		case '|': set_token(Token_bar); break;
+		case '[': set_token(Token_leftBracket); break;
+		case ']': set_token(Token_rightBracket); break;
+		case '^': set_token(Token_ptr); break;
+		case '&': set_token(Token_andop); break;
+		case '~': set_token(Token_notop); break;
+		case '{': set_token(Token_leftBrace); break;
+		case '}': set_token(Token_rightBrace); break;
+		case '.': set_bi_char_token('.', Token_range, Token_period); break;
+		case ':': set_bi_char_token('=', Token_assign, Token_colon); break;
+		case '<': set_bi_char_token('=', Token_lessOrEqual, Token_less); break;
+		case '>':
+			set_bi_char_token('=', Token_greaterOrEqual, Token_greater); break;
+		case '"': {
+			++start;
+			do { ++pos; } while (pos != end && *pos != '"');
+			value = { start, static_cast<std::size_t>(pos - start) };
+			if (pos == end) {
+				token = Token_unknown;
+			} else {
+				set_token(Token_stringLiteral);
+			}
+			break;
+		}
+		case '(':
+			++pos;
+			if (pos != end && *pos == '*') {
+				do_comment();
+			} else {
+				token = Token_leftParenthesis;
+			}
+			break;
+		default: set_token(Token_unknown);
+	}
+}
+
+void State::consume(const Token& tok) {
+	expect(tok);
+	advance();
+}
+
+ModuleHeader read_module_header(const std::string& path) {
+	Source source { path };
+	Module module;
+	State state { "", source, module };
+	state.consume(Token_kwMODULE);
+	state.expect(Token_identifier);
+	ModuleHeader header { std::string { state.value }, { } };
+	state.advance();
+	state.consume(Token_semicolon);
+	if (state.token == Token_kwIMPORT) {
+		do {
+			state.advance();
+			state.expect(Token_identifier);
+			std::string name { state.value };
+			state.advance();
+			if (state.token == Token_assign) {
+				state.advance();
+				state.expect(Token_identifier);
+				name = state.value;
+				state.advance();
+			}
+			if (name != "SYSTEM") { header.imports.push_back(std::move(name)); }
+		} while (state.token == Token_comma);
+	}
+	return header;
+}
+
+
+void parse_module(State& state);
+void parse_import_list(State& state);
+Declarations parse_declaration_sequence(State &state);
+Statements parse_statement_sequence(State& state);
+
+void parse_module(const std::string& base, const Source& source, Module& module) {
+	State state { base, source, module };
+	module.source = source.text();
+	parse_module(state);
+}
+
+void parse_module(State& state) {
+	auto& module { state.module };
+	state.consume(Token_kwMODULE);
+	state.expect(Token_identifier);
+	module.name = state.name();
+	if (module.name.text() != state.base) {
+		throw Error { "MODULE name doesn't match file name" };
+	}
+	state.advance();
+	state.consume(Token_semicolon);
+
+	if (state.token == Token_kwIMPORT) {
+		parse_import_list(state);
+	}
+
+	module.declarations = parse_declaration_sequence(state);
+	if (state.token == Token_kwBEGIN) {
+		state.advance();
+		module.body = parse_statement_sequence(state);
+	}
+	state.consume(Token_kwEND);
+	state.expect(Token_identifier);
+	if (module.name.text() != state.value) {
+		throw Error { "MODULE names don't match" };
+	}
+	state.advance();
+	state.consume(Token_period);
+	state.expect(Token_eof);
+}
+
+void State::do_comment() {
+	throw Error { "comments not implemented" };
+}
+
+Import parse_import(State& state);
+
+void parse_import_list(State& state) {
+	state.consume(Token_kwIMPORT);
+	state.imports.push_back(parse_import(state));
+	while (state.token == Token_comma) {
+		state.advance();
+		state.imports.push_back(parse_import(state));
+	}
+	state.consume(Token_semicolon);
+	state.module.imports = make_span(state.module.arena, state.imports);
+}
+
+Import parse_import(State& state) {
+	state.expect(Token_identifier);
+	auto name { state.name() };
+	auto full_name { name };
+	state.advance();
+	if (state.token == Token_assign) {
+		state.advance();
+		state.expect(Token_identifier);
+		full_name = state.name();
+		state.advance();
+	}
+	return { name, full_name };
+}
+
+ConstDecl* parse_const_declaration(State& state);
+TypeDecl* parse_type_declaration(State& state);
+VarDecl* parse_variable_declaration(State& state);
+ProcDecl* parse_procedure_declaration(State& state);
+
+Declarations parse_declaration_sequence(State& state) {
+	Declarations result;
+	if (state.token == Token_kwCONST) {
+		state.advance();
+		std::vector<ConstDecl*> consts;
+		while (state.token == Token_identifier) {
+			consts.push_back(parse_const_declaration(state));
+			state.consume(Token_semicolon);
+		}
+		result.consts = make_span(state.module.arena, consts);
+	}
+	if (state.token == Token_kwTYPE) {
+		state.advance();
+		std::vector<TypeDecl*> types;
+		while (state.token == Token_identifier) {
+			types.push_back(parse_type_declaration(state));
+			state.consume(Token_semicolon);
+		}
+		result.types = make_span(state.module.arena, types);
+	}
+	if (state.token == Token_kwVAR) {
+		state.advance();
+		std::vector<VarDecl*> vars;
+		while (state.token == Token_identifier) {
+			vars.push_back(parse_variable_declaration(state));
+			state.consume(Token_semicolon);
+		}
+		result.vars = make_span(state.module.arena, vars);
+	}
+
+	std::vector<ProcDecl*> procedures;
+	while (state.token == Token_kwPROCEDURE) {
+		procedures.push_back(parse_procedure_declaration(state));
+		state.consume(Token_semicolon);
+	}
+	result.procedures = make_span(state.module.arena, procedures);
+	return result;
+}
+
+Expr* parse_const_expression(State& state);
+IdentDef parse_ident_def(State& state);
+
+ConstDecl* parse_const_declaration(State& state) {
+	auto ident { parse_ident_def(state) };
+	state.consume(Token_equals);
+	return state.make<ConstDecl>(ident, parse_const_expression(state));
+}
+
+IdentDef parse_ident_def(State& state) {
+	state.expect(Token_identifier);
+	IdentDef result { state.name(), false, state.position() };
+	state.advance();
+	if (state.token == Token_star) {
+		result.exported = true;
+		state.advance();
+	}
+	return result;
+}
+
+Expr* parse_expression(State& state);
+
+Expr* parse_const_expression(State& state) {
+	return parse_expression(state);
+}
+
+Type* parse_type(State& state);
+
+TypeDecl* parse_type_declaration(State& state) {
+	auto ident { parse_ident_def(state) };
+	state.consume(Token_equals);
+	return state.make<TypeDecl>(ident, parse_type(state));
+}
+
+Span<IdentDef> parse_ident_list(State& state);
+
+VarDecl* parse_variable_declaration(State& state) {
+	auto names { parse_ident_list(state) };
+	state.consume(Token_colon);
+	return state.make<VarDecl>(names, parse_type(state));
+}
+
+Span<IdentDef> parse_ident_list(State& state) {
+	std::vector<IdentDef> idents { parse_ident_def(state) };
+	while (state.token == Token_comma) {
+		state.advance();
+		idents.push_back(parse_ident_def(state));
+	}
+	return make_span(state.module.arena, idents);
+}
+
+QualIdent parse_qual_ident(State& state);
+Span<Expr*> parse_expression_list(State& state);
+Type* parse_array_type(State& state);
+Type* parse_record_type(State& state);
+Type* parse_pointer_type(State& state);
+Type* parse_procedure_type(State& state);
+
+Type* parse_named_type(State& state) {
+	auto pos { state.position() };
+	return state.make<NamedType>(Type { TypeKind::named, pos }, parse_qual_ident(state));
+}
+
+Type* parse_type(State& state) {
+	if (state.token == Token_identifier) {
+		return parse_named_type(state);
+	} else if (state.token == Token_kwARRAY) {
+		return parse_array_type(state);
+	} else if (state.token == Token_kwRECORD) {
+		return parse_record_type(state);
+	} else if (state.token == Token_kwPOINTER) {
+		return parse_pointer_type(state);
+	} else if (state.token == Token_kwPROCEDURE) {
+		return parse_procedure_type(state);
+	} else {
+		throw Error { "type expected" };
+	}
+}
+
+// ARRAY L0, L1 OF T is short for ARRAY L0 OF ARRAY L1 OF T
+Type* parse_array_type(State& state) {
+	auto pos { state.position() };
+	state.consume(Token_kwARRAY);
+	auto lengths { parse_expression_list(state) };
+	state.consume(Token_kwOF);
+	return state.make<ArrayType>(Type { TypeKind::array, pos }, lengths, parse_type(state));
+}
+
+Type* parse_base_type(State& state);
+Span<FieldList> parse_field_list_sequence(State& state);
+
+Type* parse_record_type(State& state) {
+	auto record { state.make<RecordType>(Type { TypeKind::record, state.position() }) };
+	state.consume(Token_kwRECORD);
+	if (state.token == Token_leftParenthesis) {
+		state.advance();
+		record->base = parse_base_type(state);
+		state.consume(Token_rightParenthesis);
+	}
+	if (state.token != Token_kwEND) {
+		record->fields = parse_field_list_sequence(state);
+	}
+	state.consume(Token_kwEND);
+	return record;
+}
+
+Type* parse_base_type(State& state) {
+	return parse_named_type(state);
+}
+
+FieldList parse_field_list(State& state) {
+	auto names { parse_ident_list(state) };
+	state.consume(Token_colon);
+	return { names, parse_type(state) };
+}
+
+// a semicolon before END is allowed
+Span<FieldList> parse_field_list_sequence(State& state) {
+	std::vector<FieldList> fields { parse_field_list(state) };
+	while (state.token == Token_semicolon) {
+		state.advance();
+		if (state.token == Token_kwEND) { break; }
+		fields.push_back(parse_field_list(state));
+	}
+	return make_span(state.module.arena, fields);
+}
+
+// the target is a name, which may be declared later, or a record
+Type* parse_pointer_type(State& state) {
+	auto pos { state.position() };
+	state.consume(Token_kwPOINTER);
+	state.consume(Token_kwTO);
+	auto target { parse_type(state) };
+	if (target->kind != TypeKind::named && target->kind != TypeKind::record) {
+		throw Error { "POINTER TO needs a record type" };
+	}
+	return state.make<PointerType>(Type { TypeKind::pointer, pos }, target);
+}
+
+Type* parse_procedure_type(State& state) {
+	throw Error { "parse_procedure_type not implemented" };
+}
+
+Signature* parse_formal_parameters(State& state);
+void parse_procedure_body(State& state, ProcDecl& procedure);
+
+ProcDecl* parse_procedure_declaration(State& state) {
+	state.consume(Token_kwPROCEDURE);
+	auto procedure { state.make<ProcDecl>(parse_ident_def(state)) };
+	procedure->signature = parse_formal_parameters(state);
+	state.consume(Token_semicolon);
+
+	parse_procedure_body(state, *procedure);
+	state.expect(Token_identifier);
+	if (state.name() != procedure->ident.name) {
+		throw Error { "PROCEDURE names don't match" };
+	}
+	state.advance();
+	return procedure;
+}
+
+ParameterSection parse_formal_parameter_section(State& state);
+
+Signature* parse_formal_parameters(State& state) {
+	auto signature { state.make<Signature>() };
+	state.consume(Token_leftParenthesis);
+	if (state.token != Token_rightParenthesis) {
+		std::vector<ParameterSection> sections {
+			parse_formal_parameter_section(state)
+		};
+		while (state.token == Token_semicolon) {
+			state.advance();
+			sections.push_back(parse_formal_parameter_section(state));
+		}
+		signature->sections = make_span(state.module.arena, sections);
+	}
+	state.consume(Token_rightParenthesis);
+	if (state.token == Token_colon) {
+		state.advance();
+		signature->result = parse_named_type(state);
+	}
+	return signature;
+}
+
+Type* parse_formal_type(State& state);
+
+ParameterSection parse_formal_parameter_section(State& state) {
+	ParameterSection section { };
+	if (state.token == Token_kwVAR) { section.reference = true; state.advance(); }
+	std::vector<IdentDef> names;
+	state.expect(Token_identifier);
+	names.push_back({ state.name(), false, state.position() });
+	state.advance();
+	while (state.token == Token_comma) {
+		state.advance();
+		state.expect(Token_identifier);
+		names.push_back({ state.name(), false, state.position() });
+		state.advance();
+	}
+	section.names = make_span(state.module.arena, names);
+
+	state.consume(Token_colon);
+	section.type = parse_formal_type(state);
+	return section;
+}
+
+Type* parse_formal_type(State& state) {
+	if (state.token == Token_kwARRAY) {
+		auto pos { state.position() };
+		state.advance();
+		state.consume(Token_kwOF);
+		return state.make<OpenArrayType>(
+			Type { TypeKind::open_array, pos }, parse_formal_type(state)
+		);
+	}
+	return parse_named_type(state);
+}
+
+void parse_procedure_body(State& state, ProcDecl& procedure) {
+	procedure.declarations = parse_declaration_sequence(state);
+	if (state.token == Token_kwBEGIN) {
+		state.advance();
+		procedure.body = parse_statement_sequence(state);
+	}
+	if (state.token == Token_kwRETURN) {
+		state.advance();
+		procedure.result = parse_expression(state);
+	}
+	state.consume(Token_kwEND);
+}
+
+Stmt* parse_statement(State& state);
+
+Statements parse_statement_sequence(State& state) {
+	std::vector<Stmt*> statements;
+	for (;;) {
+		if (auto statement { parse_statement(state) }) {
+			statements.push_back(statement);
+		}
+		if (state.token != Token_semicolon) { break; }
+		state.advance();
+	}
+	return make_span(state.module.arena, statements);
+}
+
+Stmt* parse_assignment_or_procedure_call(State& state);
+Stmt* parse_if_statement(State& state);
+Stmt* parse_case_statement(State& state);
+Stmt* parse_while_statement(State& state);
+Stmt* parse_repeat_statement(State& state);
+Stmt* parse_for_statement(State& state);
+
+Stmt* parse_statement(State& state) {
+	if (state.token == Token_identifier) {
+		return parse_assignment_or_procedure_call(state);
+	} else if (state.token == Token_kwIF) {
+		return parse_if_statement(state);
+	} else if (state.token == Token_kwCASE) {
+		return parse_case_statement(state);
+	} else if (state.token == Token_kwWHILE) {
+		return parse_while_statement(state);
+	} else if (state.token == Token_kwREPEAT) {
+		return parse_repeat_statement(state);
+	} else if (state.token == Token_kwFOR) {
+		return parse_for_statement(state);
+	}
+	return nullptr;
+}
+
+Expr* parse_designator(State& state);
+Span<Expr*> parse_actual_parameters(State& state);
+
+Stmt* parse_assignment_or_procedure_call(State& state) {
+	auto pos { state.position() };
+	auto designator { parse_designator(state) };
+	if (state.token == Token_assign) {
+		state.advance();
+		return state.make<Assignment>(
+			Stmt { StmtKind::assignment, pos }, designator, parse_expression(state)
+		);
+	}
+	return state.make<CallStmt>(Stmt { StmtKind::call, pos }, designator);
+}
+
+Span<Expr*> parse_expression_list(State& state);
+
+// A type guard x(T) looks like a call with one argument; the emitter
+// tells them apart by the type of x.
+Expr* parse_designator(State& state) {
+	auto start { state.position() };
+	auto pos { start };
+	Expr* designator { state.make<Ident>(
+		Expr { ExprKind::ident, pos }, parse_qual_ident(state)
+	) };
+
+	for (;;) {
+		pos = state.position();
+		if (state.token == Token_period) {
+			state.advance();
+			state.expect(Token_identifier);
+			designator = state.make<Field>(
+				Expr { ExprKind::field, pos }, designator, state.name()
+			);
+			state.advance();
+		} else if (state.token == Token_leftBracket) {
+			state.advance();
+			designator = state.make<Index>(
+				Expr { ExprKind::index, pos }, designator, parse_expression_list(state)
+			);
+			state.consume(Token_rightBracket);
+		} else if (state.token == Token_ptr) {
+			designator = state.make<Deref>(Expr { ExprKind::deref, pos }, designator);
+			state.advance();
+		} else if (state.token == Token_leftParenthesis) {
+			designator = state.make<Call>(
+				Expr { ExprKind::call, start }, designator, parse_actual_parameters(state)
+			);
+		} else { break; }
+	}
+	return designator;
+}
+
+QualIdent parse_qual_ident(State& state) {
+	state.expect(Token_identifier);
+	QualIdent result { { }, state.name() };
+	state.advance();
+	if (state.is_module(result.name)) {
+		if (state.token == Token_period) {
+			state.advance();
+			state.expect(Token_identifier);
+			result.module = result.name;
+			result.name = state.name();
+			state.advance();
+		} else { throw Error { ". after module expected" }; }
+	}
+	return result;
+}
+
+Span<Expr*> parse_expression_list(State& state) {
+	std::vector<Expr*> result { parse_expression(state) };
+	while (state.token == Token_comma) {
+		state.advance();
+		result.push_back(parse_expression(state));
+	}
+	return make_span(state.module.arena, result);
+}
+
+Expr* parse_simple_expression(State& state);
+
+Expr* parse_expression(State& state) {
+	auto result { parse_simple_expression(state) };
+	for (;;) {
+		auto pos { state.position() };
+		auto op { state.token };
+		switch (op) {
+			case Token_equals: case Token_notEquals:
+			case Token_less: case Token_lessOrEqual:
+			case Token_greater: case Token_greaterOrEqual:
+				break;
+			case Token_kwIN:
+				break;
+			case Token_kwIS: {
+				state.advance();
+				auto type_pos { state.position() };
+				auto type { state.make<Ident>(Expr { ExprKind::ident, type_pos }, parse_qual_ident(state)) };
+				result = state.make<Binary>(Expr { ExprKind::binary, pos }, op, result, type);
+				continue;
+			}
+			default: return result;
+		}
+		state.advance();
+		result = state.make<Binary>(
+			Expr { ExprKind::binary, pos }, op, result, parse_simple_expression(state)
+		);
+	}
+}
+
+Expr* parse_term(State& state);
+
+Expr* parse_simple_expression(State& state) {
+	auto pos { state.position() };
+	Expr* result;
+	if (state.token == Token_plus || state.token == Token_minus) {
+		auto op { state.token };
+		state.advance();
+		result = state.make<Unary>(Expr { ExprKind::unary, pos }, op, parse_term(state));
+	} else {
+		result = parse_term(state);
+	}
+
+	for (;;) {
+		pos = state.position();
+		auto op { state.token };
+		switch (op) {
+			case Token_plus: case Token_minus: case Token_kwOR: break;
+			default: return result;
+		}
+		state.advance();
+		result = state.make<Binary>(
+			Expr { ExprKind::binary, pos }, op, result, parse_term(state)
+		);
+	}
+}
+
+Expr* parse_factor(State& state);
+
+Expr* parse_term(State& state) {
+	auto result { parse_factor(state) };
+
+	for (;;) {
+		auto pos { state.position() };
+		auto op { state.token };
+		switch (op) {
+			case Token_star: case Token_slash: case Token_kwDIV:
+			case Token_kwMOD: case Token_andop:
+				break;
+			default: return result;
+		}
+		state.advance();
+		result = state.make<Binary>(
+			Expr { ExprKind::binary, pos }, op, result, parse_factor(state)
+		);
+	}
+}
+
+Expr* parse_set(State& state);
+
+Expr* parse_literal(State& state, ExprKind kind) {
+	auto result { state.make<Literal>(Expr { kind, state.position() }, state.value) };
+	state.advance();
+	return result;
+}
+
+Expr* parse_factor(State& state) {
+	auto pos { state.position() };
+	switch (state.token) {
+		case Token_integerLiteral:
+			return parse_literal(state, ExprKind::integer);
+		case Token_floatLiteral:
+			return parse_literal(state, ExprKind::real);
+		case Token_stringLiteral:
+			return parse_literal(state, ExprKind::string);
+		case Token_charLiteral:
+			return parse_literal(state, ExprKind::character);
+		case Token_kwNIL:
+			state.advance();
+			return state.make<Expr>(Expr { ExprKind::nil, pos });
+		case Token_kwTRUE:
+		case Token_kwFALSE: {
+			bool value { state.token == Token_kwTRUE };
+			state.advance();
+			return state.make<BooleanLiteral>(Expr { ExprKind::boolean, pos }, value);
+		}
+		case Token_leftBrace:
+			return parse_set(state);
+		case Token_identifier:
+			return parse_designator(state);
+		case Token_leftParenthesis: {
+			state.advance();
+			auto inner { parse_expression(state) };
+			state.consume(Token_rightParenthesis);
+			return state.make<Paren>(Expr { ExprKind::paren, pos }, inner);
+		}
+		case Token_notop: {
+			state.advance();
+			return state.make<Unary>(
+				Expr { ExprKind::unary, pos }, Token_notop, parse_factor(state)
+			);
+		}
+		default: throw Error { "factor expected "};
+	}
+}
+
+Expr* parse_set(State& state) {
+	auto set { state.make<SetExpr>(Expr { ExprKind::set, state.position() }) };
+	state.consume(Token_leftBrace);
+	std::vector<SetElement> elements;
+	if (state.token != Token_rightBrace) {
+		for (;;) {
+			SetElement element { parse_expression(state), nullptr };
+			if (state.token == Token_range) {
+				state.advance();
+				element.high = parse_expression(state);
+			}
+			elements.push_back(element);
+			if (state.token != Token_comma) { break; }
+			state.advance();
+		}
+	}
+	state.consume(Token_rightBrace);
+	set->elements = make_span(state.module.arena, elements);
+	return set;
+}
+
+Span<Expr*> parse_actual_parameters(State& state) {
+	Span<Expr*> result;
+	state.consume(Token_leftParenthesis);
+	if (state.token != Token_rightParenthesis) {
+		result = parse_expression_list(state);
+	}
+	state.consume(Token_rightParenthesis);
+	return result;
+}
+
+Branch parse_branch(State& state, const Token& separator) {
+	auto condition { parse_expression(state) };
+	state.consume(separator);
+	return { condition, parse_statement_sequence(state) };
+}
+
+Stmt* parse_if_statement(State& state) {
+	auto statement { state.make<IfStmt>(Stmt { StmtKind::if_then, state.position() }) };
+	state.consume(Token_kwIF);
+	std::vector<Branch> branches { parse_branch(state, Token_kwTHEN) };
+	while (state.token == Token_kwELSIF) {
+		state.advance();
+		branches.push_back(parse_branch(state, Token_kwTHEN));
+	}
+	statement->branches = make_span(state.module.arena, branches);
+	if (state.token == Token_kwELSE) {
+		state.advance();
+		statement->has_else = true;
+		statement->otherwise = parse_statement_sequence(state);
+	}
+	state.consume(Token_kwEND);
+	return statement;
+}
+
+CaseLabel parse_case_label(State& state) {
+	CaseLabel label { parse_const_expression(state), nullptr };
+	if (state.token == Token_range) {
+		state.advance();
+		label.high = parse_const_expression(state);
+	}
+	return label;
+}
+
+// empty cases between bars are left out
+Stmt* parse_case_statement(State& state) {
+	auto statement { state.make<CaseStmt>(Stmt { StmtKind::case_of, state.position() }) };
+	state.consume(Token_kwCASE);
+	statement->selector = parse_expression(state);
+	state.consume(Token_kwOF);
+	std::vector<Case> cases;
+	for (;;) {
+		if (state.token != Token_bar && state.token != Token_kwELSE && state.token != Token_kwEND) {
+			std::vector<CaseLabel> labels { parse_case_label(state) };
+			while (state.token == Token_comma) {
+				state.advance();
+				labels.push_back(parse_case_label(state));
+			}
+			state.consume(Token_colon);
+			cases.push_back({ make_span(state.module.arena, labels), parse_statement_sequence(state) });
+		}
+		if (state.token != Token_bar) { break; }
+		state.advance();
+	}
+	statement->cases = make_span(state.module.arena, cases);
+	if (state.token == Token_kwELSE) {
+		state.advance();
+		statement->has_else = true;
+		statement->otherwise = parse_statement_sequence(state);
+	}
+	state.consume(Token_kwEND);
+	return statement;
+}
+
+Stmt* parse_while_statement(State& state) {
+	auto statement { state.make<WhileStmt>(Stmt { StmtKind::while_do, state.position() }) };
+	state.consume(Token_kwWHILE);
+	std::vector<Branch> branches { parse_branch(state, Token_kwDO) };
+	while (state.token == Token_kwELSIF) {
+		state.advance();
+		branches.push_back(parse_branch(state, Token_kwDO));
+	}
+	statement->branches = make_span(state.module.arena, branches);
+	state.consume(Token_kwEND);
+	return statement;
+}
+
+Stmt* parse_repeat_statement(State& state) {
+	auto statement { state.make<RepeatStmt>(Stmt { StmtKind::repeat_until, state.position() }) };
+	state.consume(Token_kwREPEAT);
+	statement->body = parse_statement_sequence(state);
+	state.consume(Token_kwUNTIL);
+	statement->condition = parse_expression(state);
+	return statement;
+}
+
+Stmt* parse_for_statement(State& state) {
+	auto statement { state.make<ForStmt>(Stmt { StmtKind::for_do, state.position() }) };
+	state.consume(Token_kwFOR);
+	state.expect(Token_identifier);
+	statement->control = state.name();
+	state.advance();
+	state.consume(Token_assign);
+	statement->begin = parse_expression(state);
+	state.consume(Token_kwTO);
+	statement->end = parse_expression(state);
+	if (state.token == Token_kwBY) {
+		state.advance();
+		statement->step = parse_const_expression(state);
+	}
+	state.consume(Token_kwDO);
+	statement->body = parse_statement_sequence(state);
+	state.consume(Token_kwEND);
+	return statement;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "source.h"
+
+// MODULE and IMPORT part of a module, read without translating it
+struct ModuleHeader {
+	std::string name;
+	std::vector<std::string> imports;
+};
+
+ModuleHeader read_module_header(const std::string& path);
+
+// Parses source into module; the module name has to match base
+void parse_module(const std::string& base, const Source& source, Module& module);
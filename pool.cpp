@@ -0,0 +1,89 @@
+#include "pool.h"
+
+namespace {
+	thread_local const void* current_pool { nullptr };
+	thread_local unsigned current_worker { 0 };
+}
+
+Pool::Pool(unsigned workers) {
+	if (workers == 0) { workers = 1; }
+	for (unsigned i { 0 }; i < workers; ++i) {
+		queues_.push_back(std::make_unique<Queue>());
+	}
+	for (unsigned i { 0 }; i < workers; ++i) {
+		threads_.emplace_back([this, i] { run(i); });
+	}
+}
+
+Pool::~Pool() {
+	{
+		std::lock_guard lock { state_mutex_ };
+		stopping_ = true;
+	}
+	work_available_.notify_all();
+	for (auto& thread : threads_) { thread.join(); }
+}
+
+void Pool::submit(Task task) {
+	unsigned target {
+		current_pool == this ? current_worker :
+			next_queue_++ % static_cast<unsigned>(queues_.size())
+	};
+	{
+		std::lock_guard lock { queues_[target]->mutex };
+		queues_[target]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard lock { state_mutex_ };
+		++queued_;
+		++unfinished_;
+	}
+	work_available_.notify_one();
+}
+
+void Pool::wait() {
+	std::unique_lock lock { state_mutex_ };
+	all_done_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool Pool::take(unsigned self, Task& task) {
+	auto count { static_cast<unsigned>(queues_.size()) };
+	{
+		auto& own { *queues_[self] };
+		std::lock_guard lock { own.mutex };
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	for (unsigned i { 1 }; i < count; ++i) {
+		auto& victim { *queues_[(self + i) % count] };
+		std::lock_guard lock { victim.mutex };
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void Pool::run(unsigned self) {
+	current_pool = this;
+	current_worker = self;
+	for (;;) {
+		{
+			std::unique_lock lock { state_mutex_ };
+			work_available_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+			if (queued_ == 0) { return; }
+			--queued_;
+		}
+		// a task is reserved for this worker, so some queue holds it
+		Task task;
+		while (!take(self, task)) { std::this_thread::yield(); }
+		task();
+		std::lock_guard lock { state_mutex_ };
+		if (--unfinished_ == 0) { all_done_.notify_all(); }
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool: every worker owns a queue, takes its newest
+// task first and steals the oldest task of another worker when idle.
+// Tasks submitted by a worker go to its own queue.
+
+class Pool {
+	public:
+		using Task = std::function<void()>;
+
+		explicit Pool(unsigned workers);
+		~Pool();
+		Pool(const Pool&) = delete;
+		Pool& operator=(const Pool&) = delete;
+
+		void submit(Task task);
+		void wait();
+
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues_;
+		std::vector<std::thread> threads_;
+		std::atomic<unsigned> next_queue_ { 0 };
+
+		std::mutex state_mutex_;
+		std::condition_variable work_available_;
+		std::condition_variable all_done_;
+		std::size_t queued_ { 0 };
+		std::size_t unfinished_ { 0 };
+		bool stopping_ { false };
+
+		bool take(unsigned self, Task& task);
+		void run(unsigned self);
+};
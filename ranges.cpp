@@ -0,0 +1,441 @@
+#include "ranges.h"
+
+#include <algorithm>
+
+#include "Token.h"
+
+namespace {
+	// unqualified variable name, empty for other expressions
+	std::string_view variable(const Expr* expr) {
+		while (expr->kind == ExprKind::paren) { expr = static_cast<const Paren*>(expr)->inner; }
+		if (expr->kind != ExprKind::ident) { return { }; }
+		const auto& ident { static_cast<const Ident*>(expr)->ident };
+		return ident.module.empty() ? ident.name.text() : std::string_view { };
+	}
+
+	const Value* integer_constant(const Expr* expr) {
+		if (expr->kind != ExprKind::constant) { return nullptr; }
+		const auto& value { static_cast<const Constant*>(expr)->value };
+		return value.kind == ValueKind::integer ? &value : nullptr;
+	}
+
+	// predeclared functions without side effects
+	bool is_pure(const Call& call) {
+		auto name { variable(call.procedure) };
+		return name == "LEN" || name == "ABS" || name == "ODD" || name == "ORD" ||
+			name == "CHR" || name == "FLT" || name == "FLOOR";
+	}
+
+	// INCL and EXCL only change their first argument
+	bool is_set_update(const Call& call) {
+		auto name { variable(call.procedure) };
+		return (name == "INCL" || name == "EXCL") && !call.arguments.empty();
+	}
+
+	std::int64_t floor_div(std::int64_t x, std::int64_t y) {
+		auto quotient { x / y };
+		return (x % y != 0 && ((x < 0) != (y < 0))) ? quotient - 1 : quotient;
+	}
+
+	// How the variables of a loop body change: 1 if they only grow by
+	// constants, -1 if they only shrink, 0 otherwise
+	class Changes {
+		private:
+			const Facts::SignatureLookup& signature_;
+
+		public:
+			std::map<std::string_view, int> direction;
+			bool calls { false };
+			// assignments to array elements, fields and dereferences
+			bool stores { false };
+
+			explicit Changes(const Facts::SignatureLookup& signature): signature_ { signature } { }
+
+			void change(std::string_view name, int how) {
+				if (name.empty()) { return; }
+				auto got { direction.emplace(name, how) };
+				if (!got.second && got.first->second != how) { got.first->second = 0; }
+			}
+
+			void assignment(const Assignment& assignment) {
+				auto name { variable(assignment.target) };
+				if (name.empty()) {
+					stores = true;
+					return;
+				}
+				int how { 0 };
+				if (assignment.value->kind == ExprKind::binary) {
+					const auto& binary { *static_cast<const Binary*>(assignment.value) };
+					const Value* step { nullptr };
+					bool plus { binary.op == Token_plus };
+					if ((plus || binary.op == Token_minus) && variable(binary.left) == name) {
+						step = integer_constant(binary.right);
+					} else if (plus && variable(binary.right) == name) {
+						step = integer_constant(binary.left);
+					}
+					if (step) {
+						auto delta { plus ? step->integer : -step->integer };
+						how = delta >= 0 ? 1 : -1;
+					}
+				}
+				change(name, how);
+			}
+
+			void expression(const Expr* expr) {
+				if (!expr) { return; }
+				switch (expr->kind) {
+					case ExprKind::call: {
+						const auto& call { *static_cast<const Call*>(expr) };
+						for (const auto* argument : call.arguments) { expression(argument); }
+						if (is_pure(call)) { break; }
+						if (is_set_update(call)) {
+							change(variable(call.arguments[0]), 0);
+							break;
+						}
+						calls = true;
+						auto signature { signature_ ? signature_(call.procedure) : nullptr };
+						std::uint32_t index { 0 };
+						std::vector<bool> reference;
+						if (signature) {
+							for (const auto& section : signature->sections) {
+								for (std::uint32_t i { 0 }; i < section.names.size(); ++i) {
+									reference.push_back(section.reference);
+								}
+							}
+						}
+						for (const auto* argument : call.arguments) {
+							if (!signature || index >= reference.size() || reference[index]) {
+								change(variable(argument), 0);
+							}
+							++index;
+						}
+						break;
+					}
+					case ExprKind::field:
+						expression(static_cast<const Field*>(expr)->base);
+						break;
+					case ExprKind::index: {
+						const auto& index { *static_cast<const Index*>(expr) };
+						expression(index.base);
+						for (const auto* item : index.indices) { expression(item); }
+						break;
+					}
+					case ExprKind::deref:
+						expression(static_cast<const Deref*>(expr)->base);
+						break;
+					case ExprKind::unary:
+						expression(static_cast<const Unary*>(expr)->operand);
+						break;
+					case ExprKind::binary:
+						expression(static_cast<const Binary*>(expr)->left);
+						expression(static_cast<const Binary*>(expr)->right);
+						break;
+					case ExprKind::paren:
+						expression(static_cast<const Paren*>(expr)->inner);
+						break;
+					case ExprKind::set:
+						for (const auto& element : static_cast<const SetExpr*>(expr)->elements) {
+							expression(element.low);
+							expression(element.high);
+						}
+						break;
+					default:
+						break;
+				}
+			}
+
+			void statements(const Statements& statements) {
+				for (const auto* statement : statements) {
+					switch (statement->kind) {
+						case StmtKind::assignment: {
+							const auto& assignment { *static_cast<const Assignment*>(statement) };
+							expression(assignment.target);
+							expression(assignment.value);
+							this->assignment(assignment);
+							break;
+						}
+						case StmtKind::call: {
+							const auto* call { static_cast<const CallStmt*>(statement)->call };
+							if (call->kind == ExprKind::call) {
+								expression(call);
+							} else {
+								calls = true;
+							}
+							break;
+						}
+						case StmtKind::if_then: {
+							const auto& if_stmt { *static_cast<const IfStmt*>(statement) };
+							for (const auto& branch : if_stmt.branches) {
+								expression(branch.condition);
+								this->statements(branch.body);
+							}
+							this->statements(if_stmt.otherwise);
+							break;
+						}
+						case StmtKind::case_of: {
+							const auto& case_stmt { *static_cast<const CaseStmt*>(statement) };
+							expression(case_stmt.selector);
+							for (const auto& item : case_stmt.cases) { this->statements(item.body); }
+							this->statements(case_stmt.otherwise);
+							break;
+						}
+						case StmtKind::while_do:
+							for (const auto& branch : static_cast<const WhileStmt*>(statement)->branches) {
+								expression(branch.condition);
+								this->statements(branch.body);
+							}
+							break;
+						case StmtKind::repeat_until: {
+							const auto& repeat { *static_cast<const RepeatStmt*>(statement) };
+							this->statements(repeat.body);
+							expression(repeat.condition);
+							break;
+						}
+						case StmtKind::for_do: {
+							const auto& for_stmt { *static_cast<const ForStmt*>(statement) };
+							expression(for_stmt.begin);
+							expression(for_stmt.end);
+							change(for_stmt.control.text(), 0);
+							this->statements(for_stmt.body);
+							break;
+						}
+					}
+				}
+			}
+	};
+}
+
+Range Facts::range(const Expr* expr) const {
+	Range result;
+	switch (expr->kind) {
+		case ExprKind::constant:
+			if (auto value { integer_constant(expr) }) {
+				result.has_lower = result.has_upper = true;
+				result.lower = result.upper = value->integer;
+			}
+			break;
+		case ExprKind::ident: {
+			auto got { ranges_.find(variable(expr)) };
+			if (got != ranges_.end()) { result = got->second; }
+			break;
+		}
+		case ExprKind::paren:
+			result = range(static_cast<const Paren*>(expr)->inner);
+			break;
+		case ExprKind::call: {
+			const auto& call { *static_cast<const Call*>(expr) };
+			if (variable(call.procedure) == "LEN" && call.arguments.size() == 1 &&
+				!(signature_ && signature_(call.procedure))
+			) {
+				result.has_lower = true;
+				result.length_of = variable(call.arguments[0]);
+			}
+			break;
+		}
+		case ExprKind::unary: {
+			const auto& unary { *static_cast<const Unary*>(expr) };
+			auto operand { range(unary.operand) };
+			if (unary.op == Token_plus) {
+				result = operand;
+			} else if (unary.op == Token_minus) {
+				result.has_lower = operand.has_upper;
+				result.lower = -operand.upper;
+				result.has_upper = operand.has_lower;
+				result.upper = -operand.lower;
+			}
+			break;
+		}
+		case ExprKind::binary: {
+			const auto& binary { *static_cast<const Binary*>(expr) };
+			auto left { range(binary.left) }, right { range(binary.right) };
+			switch (binary.op) {
+				case Token_plus:
+					result.has_lower = left.has_lower && right.has_lower;
+					result.lower = left.lower + right.lower;
+					result.has_upper = left.has_upper && right.has_upper;
+					result.upper = left.upper + right.upper;
+					if (!left.length_of.empty() && right.has_upper) {
+						result.length_of = left.length_of;
+						result.length_offset = left.length_offset + right.upper;
+					} else if (!right.length_of.empty() && left.has_upper) {
+						result.length_of = right.length_of;
+						result.length_offset = right.length_offset + left.upper;
+					}
+					break;
+				case Token_minus:
+					result.has_lower = left.has_lower && right.has_upper;
+					result.lower = left.lower - right.upper;
+					result.has_upper = left.has_upper && right.has_lower;
+					result.upper = left.upper - right.lower;
+					if (!left.length_of.empty() && right.has_lower) {
+						result.length_of = left.length_of;
+						result.length_offset = left.length_offset - right.lower;
+					}
+					break;
+				case Token_star:
+					if (left.has_lower && right.has_lower && left.lower >= 0 && right.lower >= 0) {
+						result.has_lower = true;
+						result.lower = left.lower * right.lower;
+						result.has_upper = left.has_upper && right.has_upper;
+						result.upper = left.upper * right.upper;
+					}
+					break;
+				case Token_kwDIV:
+					if (auto divisor { integer_constant(binary.right) }; divisor && divisor->integer > 0) {
+						result.has_lower = left.has_lower;
+						result.lower = left.has_lower ? floor_div(left.lower, divisor->integer) : 0;
+						result.has_upper = left.has_upper;
+						result.upper = left.has_upper ? floor_div(left.upper, divisor->integer) : 0;
+						// x DIV c <= x for x >= 0
+						if (left.has_lower && left.lower >= 0) {
+							result.length_of = left.length_of;
+							result.length_offset = left.length_offset;
+						}
+					}
+					break;
+				case Token_kwMOD:
+					// MOD rounds towards negative infinity, so the result has
+					// the sign of the divisor
+					if (auto divisor { integer_constant(binary.right) }; divisor && divisor->integer > 0) {
+						result.has_lower = result.has_upper = true;
+						result.lower = 0;
+						result.upper = divisor->integer - 1;
+					}
+					break;
+				default:
+					break;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	return result;
+}
+
+bool Facts::in_bounds(const Expr* index, const Expr* array, std::int64_t length) const {
+	auto got { range(index) };
+	if (!got.has_lower || got.lower < 0) { return false; }
+	if (length >= 0 && got.has_upper && got.upper < length) { return true; }
+	return array && !got.length_of.empty() && got.length_of == variable(array) &&
+		got.length_offset < 0;
+}
+
+void Facts::forget_nonlocals() {
+	for (auto it { ranges_.begin() }; it != ranges_.end();) {
+		it = locals_.count(it->first) ? std::next(it) : ranges_.erase(it);
+	}
+}
+
+void Facts::apply_calls(const Expr* expr) {
+	Changes changes { signature_ };
+	changes.expression(expr);
+	for (const auto& change : changes.direction) { ranges_.erase(change.first); }
+	if (changes.calls) { forget_nonlocals(); }
+}
+
+// variable op other holds
+void Facts::bound_by(std::string_view variable, const Token& op, const Range& other) {
+	auto& known { ranges_[variable] };
+	auto lower_bound = [&](std::int64_t offset) {
+		if (!other.has_lower) { return; }
+		known.lower = known.has_lower ? std::max(known.lower, other.lower + offset) : other.lower + offset;
+		known.has_lower = true;
+	};
+	auto upper_bound = [&](std::int64_t offset) {
+		if (other.has_upper) {
+			known.upper = known.has_upper ? std::min(known.upper, other.upper + offset) : other.upper + offset;
+			known.has_upper = true;
+		}
+		if (!other.length_of.empty()) {
+			known.length_of = other.length_of;
+			known.length_offset = other.length_offset + offset;
+		}
+	};
+	switch (op) {
+		case Token_less: upper_bound(-1); break;
+		case Token_lessOrEqual: upper_bound(0); break;
+		case Token_greater: lower_bound(1); break;
+		case Token_greaterOrEqual: lower_bound(0); break;
+		case Token_equals: lower_bound(0); upper_bound(0); break;
+		default: break;
+	}
+}
+
+void Facts::assume(const Expr* condition) {
+	while (condition->kind == ExprKind::paren) {
+		condition = static_cast<const Paren*>(condition)->inner;
+	}
+	if (condition->kind != ExprKind::binary) { return; }
+	const auto& binary { *static_cast<const Binary*>(condition) };
+	if (binary.op == Token_andop) {
+		assume(binary.left);
+		assume(binary.right);
+		return;
+	}
+	Token mirrored;
+	switch (binary.op) {
+		case Token_less: mirrored = Token_greater; break;
+		case Token_lessOrEqual: mirrored = Token_greaterOrEqual; break;
+		case Token_greater: mirrored = Token_less; break;
+		case Token_greaterOrEqual: mirrored = Token_lessOrEqual; break;
+		case Token_equals: mirrored = Token_equals; break;
+		default: return;
+	}
+	auto left { range(binary.left) }, right { range(binary.right) };
+	if (auto name { variable(binary.left) }; !name.empty()) { bound_by(name, binary.op, right); }
+	if (auto name { variable(binary.right) }; !name.empty()) { bound_by(name, mirrored, left); }
+}
+
+void Facts::narrow(const Expr* expr, std::int64_t lower, std::int64_t upper) {
+	auto name { variable(expr) };
+	if (name.empty()) { return; }
+	Range bounds;
+	bounds.has_lower = bounds.has_upper = true;
+	bounds.lower = lower;
+	bounds.upper = upper;
+	bound_by(name, Token_greaterOrEqual, bounds);
+	bound_by(name, Token_lessOrEqual, bounds);
+}
+
+void Facts::assign(const Expr* target, const Expr* value) {
+	auto name { variable(target) };
+	if (!name.empty()) {
+		set(name, range(value));
+	} else if (aliasing_) {
+		forget_nonlocals();
+	}
+}
+
+void Facts::set(std::string_view variable, const Range& range) {
+	if (aliasing_ && !locals_.count(variable)) { forget_nonlocals(); }
+	if (range.has_lower || range.has_upper || !range.length_of.empty()) {
+		ranges_[variable] = range;
+	} else {
+		ranges_.erase(variable);
+	}
+}
+
+bool Facts::enter_loop(const Statements& body, std::string_view control) {
+	Changes changes { signature_ };
+	changes.statements(body);
+	bool nonlocal_stores { changes.stores };
+	for (const auto& change : changes.direction) {
+		if (!locals_.count(change.first)) { nonlocal_stores = true; }
+	}
+	if (changes.calls || (aliasing_ && nonlocal_stores)) { forget_nonlocals(); }
+	for (const auto& [name, how] : changes.direction) {
+		auto got { ranges_.find(name) };
+		if (got == ranges_.end()) { continue; }
+		auto& known { got->second };
+		if (how > 0) {
+			known.has_upper = false;
+			known.length_of = { };
+		} else if (how < 0) {
+			known.has_lower = false;
+		} else {
+			ranges_.erase(got);
+		}
+	}
+	return control.empty() || !changes.direction.count(control);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string_view>
+
+#include "ast.h"
+
+// Values an integer expression can take. Besides a constant upper
+// bound, there can be one relative to the length of an array variable:
+// LEN(length_of) + length_offset.
+struct Range {
+	bool has_lower { false };
+	std::int64_t lower { 0 };
+	bool has_upper { false };
+	std::int64_t upper { 0 };
+	std::string_view length_of { };
+	std::int64_t length_offset { 0 };
+};
+
+// What is known about the integer variables at one point of a procedure
+// body, used to prove array indices in range. Facts are kept by name for
+// unqualified variables. Calls may change the variables they get as VAR
+// parameters and all variables that are not locals of the procedure. If
+// the procedure has VAR parameters, they may alias any other nonlocal.
+class Facts {
+	public:
+		using SignatureLookup = std::function<const Signature*(const Expr*)>;
+
+	private:
+		SignatureLookup signature_;
+		std::set<std::string_view> locals_;
+		bool aliasing_ { false };
+		std::map<std::string_view, Range> ranges_;
+
+		void forget_nonlocals();
+		void apply_calls(const Expr* expr);
+		void bound_by(std::string_view variable, const Token& op, const Range& other);
+
+	public:
+		Facts() = default;
+		Facts(SignatureLookup signature, std::set<std::string_view> locals, bool aliasing):
+			signature_ { std::move(signature) }, locals_ { std::move(locals) }, aliasing_ { aliasing }
+		{ }
+
+		Range range(const Expr* expr) const;
+		// index is in 0 .. length - 1 where length is the constant length
+		// of the dimension, or -1 if it is not known; array is the array
+		// variable if it is the first dimension, else nullptr
+		bool in_bounds(const Expr* index, const Expr* array, std::int64_t length) const;
+
+		// forgets what the calls in expr may change; call before the
+		// expression is evaluated
+		void effects(const Expr* expr) { apply_calls(expr); }
+		void assume(const Expr* condition);
+		// expr is in lower .. upper
+		void narrow(const Expr* expr, std::int64_t lower, std::int64_t upper);
+		void assign(const Expr* target, const Expr* value);
+		void forget(std::string_view variable) { ranges_.erase(variable); }
+		void set(std::string_view variable, const Range& range);
+		// keeps only what holds after body runs any number of times, as in
+		// every iteration of a loop; false if the body changes control
+		bool enter_loop(const Statements& body, std::string_view control = { });
+};
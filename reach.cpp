@@ -0,0 +1,257 @@
+#include "reach.h"
+
+namespace {
+	class Collector {
+		private:
+			const Module& module_;
+			std::set<std::string>* uses_ { nullptr };
+
+		public:
+			explicit Collector(const Module& module): module_ { module } { }
+
+			ModuleUses module();
+
+		private:
+			std::string qualified(const Name& name) const;
+			void use(const QualIdent& ident);
+
+			void declarations(const Declarations& declarations);
+			void procedure(const ProcDecl& procedure);
+			void signature(const Signature* signature);
+			void type(const Type* type);
+			void statements(const Statements& statements);
+			void expression(const Expr* expr);
+	};
+
+	std::string Collector::qualified(const Name& name) const {
+		std::string result { module_.name.text() };
+		result += '.';
+		result += name.text();
+		return result;
+	}
+
+	void Collector::use(const QualIdent& ident) {
+		if (ident.module.empty()) {
+			uses_->insert(qualified(ident.name));
+			return;
+		}
+		for (const auto& import : module_.imports) {
+			if (import.alias != ident.module) { continue; }
+			std::string name { import.module.text() };
+			name += '.';
+			name += ident.name.text();
+			uses_->insert(std::move(name));
+			return;
+		}
+	}
+
+	ModuleUses Collector::module() {
+		ModuleUses result;
+		result.name = module_.name.text();
+		auto start = [&](const IdentDef& ident) {
+			uses_ = &result.declarations[qualified(ident.name)];
+		};
+		const auto& globals { module_.declarations };
+		for (const auto* decl : globals.types) {
+			start(decl->ident);
+			type(decl->type);
+		}
+		for (const auto* decl : globals.vars) {
+			for (const auto& ident : decl->names) {
+				start(ident);
+				type(decl->type);
+			}
+		}
+		for (const auto* decl : globals.procedures) {
+			start(decl->ident);
+			procedure(*decl);
+		}
+		uses_ = &result.body;
+		statements(module_.body);
+		return result;
+	}
+
+	void Collector::declarations(const Declarations& declarations) {
+		for (const auto* decl : declarations.consts) { expression(decl->value); }
+		for (const auto* decl : declarations.types) { type(decl->type); }
+		for (const auto* decl : declarations.vars) { type(decl->type); }
+		for (const auto* decl : declarations.procedures) { procedure(*decl); }
+	}
+
+	void Collector::procedure(const ProcDecl& procedure) {
+		signature(procedure.signature);
+		declarations(procedure.declarations);
+		statements(procedure.body);
+		expression(procedure.result);
+	}
+
+	void Collector::signature(const Signature* signature) {
+		if (!signature) { return; }
+		for (const auto& section : signature->sections) { type(section.type); }
+		type(signature->result);
+	}
+
+	void Collector::type(const Type* type) {
+		if (!type) { return; }
+		switch (type->kind) {
+			case TypeKind::named:
+				use(static_cast<const NamedType*>(type)->ident);
+				break;
+			case TypeKind::array: {
+				const auto& array { *static_cast<const ArrayType*>(type) };
+				for (const auto* length : array.lengths) { expression(length); }
+				this->type(array.element);
+				break;
+			}
+			case TypeKind::open_array:
+				this->type(static_cast<const OpenArrayType*>(type)->element);
+				break;
+			case TypeKind::record: {
+				const auto& record { *static_cast<const RecordType*>(type) };
+				this->type(record.base);
+				for (const auto& fields : record.fields) { this->type(fields.type); }
+				break;
+			}
+			case TypeKind::pointer:
+				this->type(static_cast<const PointerType*>(type)->target);
+				break;
+			case TypeKind::procedure:
+				signature(static_cast<const ProcedureType*>(type)->signature);
+				break;
+		}
+	}
+
+	void Collector::statements(const Statements& statements) {
+		for (const auto* statement : statements) {
+			switch (statement->kind) {
+				case StmtKind::assignment: {
+					const auto& assignment { *static_cast<const Assignment*>(statement) };
+					expression(assignment.target);
+					expression(assignment.value);
+					break;
+				}
+				case StmtKind::call:
+					expression(static_cast<const CallStmt*>(statement)->call);
+					break;
+				case StmtKind::if_then: {
+					const auto& if_stmt { *static_cast<const IfStmt*>(statement) };
+					for (const auto& branch : if_stmt.branches) {
+						expression(branch.condition);
+						this->statements(branch.body);
+					}
+					this->statements(if_stmt.otherwise);
+					break;
+				}
+				case StmtKind::case_of: {
+					const auto& case_stmt { *static_cast<const CaseStmt*>(statement) };
+					expression(case_stmt.selector);
+					for (const auto& item : case_stmt.cases) {
+						for (const auto& label : item.labels) {
+							expression(label.low);
+							expression(label.high);
+						}
+						this->statements(item.body);
+					}
+					this->statements(case_stmt.otherwise);
+					break;
+				}
+				case StmtKind::while_do:
+					for (const auto& branch : static_cast<const WhileStmt*>(statement)->branches) {
+						expression(branch.condition);
+						this->statements(branch.body);
+					}
+					break;
+				case StmtKind::repeat_until: {
+					const auto& repeat { *static_cast<const RepeatStmt*>(statement) };
+					this->statements(repeat.body);
+					expression(repeat.condition);
+					break;
+				}
+				case StmtKind::for_do: {
+					const auto& for_stmt { *static_cast<const ForStmt*>(statement) };
+					use({ { }, for_stmt.control });
+					expression(for_stmt.begin);
+					expression(for_stmt.end);
+					expression(for_stmt.step);
+					this->statements(for_stmt.body);
+					break;
+				}
+			}
+		}
+	}
+
+	void Collector::expression(const Expr* expr) {
+		if (!expr) { return; }
+		switch (expr->kind) {
+			case ExprKind::ident:
+				use(static_cast<const Ident*>(expr)->ident);
+				break;
+			case ExprKind::field:
+				expression(static_cast<const Field*>(expr)->base);
+				break;
+			case ExprKind::index: {
+				const auto& index { *static_cast<const Index*>(expr) };
+				expression(index.base);
+				for (const auto* item : index.indices) { expression(item); }
+				break;
+			}
+			case ExprKind::deref:
+				expression(static_cast<const Deref*>(expr)->base);
+				break;
+			case ExprKind::call: {
+				const auto& call { *static_cast<const Call*>(expr) };
+				expression(call.procedure);
+				for (const auto* argument : call.arguments) { expression(argument); }
+				break;
+			}
+			case ExprKind::unary:
+				expression(static_cast<const Unary*>(expr)->operand);
+				break;
+			case ExprKind::binary: {
+				const auto& binary { *static_cast<const Binary*>(expr) };
+				expression(binary.left);
+				expression(binary.right);
+				break;
+			}
+			case ExprKind::paren:
+				expression(static_cast<const Paren*>(expr)->inner);
+				break;
+			case ExprKind::set:
+				for (const auto& element : static_cast<const SetExpr*>(expr)->elements) {
+					expression(element.low);
+					expression(element.high);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+ModuleUses collect_uses(const Module& module) {
+	return Collector { module }.module();
+}
+
+std::set<std::string> reachable(const std::vector<ModuleUses>& modules) {
+	std::map<std::string_view, const std::set<std::string>*> uses;
+	for (const auto& module : modules) {
+		for (const auto& [name, used] : module.declarations) { uses.emplace(name, &used); }
+	}
+
+	std::set<std::string> result;
+	std::vector<const std::string*> pending;
+	auto visit = [&](const std::set<std::string>& names) {
+		for (const auto& name : names) {
+			// predeclared and local names and those of modules outside
+			// the program have no entry
+			if (uses.count(name) && result.insert(name).second) { pending.push_back(&name); }
+		}
+	};
+	for (const auto& module : modules) { visit(module.body); }
+	while (!pending.empty()) {
+		auto name { pending.back() };
+		pending.pop_back();
+		visit(*uses.at(*name));
+	}
+	return result;
+}
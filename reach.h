@@ -0,0 +1,25 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+
+// Global types, variables and procedures of a module and the global
+// declarations they use, by qualified name like "Module.name". A name is
+// counted as used wherever it appears, even where a local declaration
+// shadows it, so the uses can only be too many.
+struct ModuleUses {
+	std::string name;
+	std::map<std::string, std::set<std::string>> declarations;
+	// used by the module body
+	std::set<std::string> body;
+};
+
+ModuleUses collect_uses(const Module& module);
+
+// Qualified names of the declarations that the module bodies reach
+// through calls and other uses.
+std::set<std::string> reachable(const std::vector<ModuleUses>& modules);
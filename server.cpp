@@ -0,0 +1,414 @@
+#include "server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+	using Error = std::runtime_error;
+
+	class JsonParser {
+		private:
+			std::string_view text_;
+			std::size_t pos_ { 0 };
+
+		public:
+			explicit JsonParser(std::string_view text): text_ { text } { }
+
+			Json document();
+
+		private:
+			void skip_whitespace();
+			bool consume(char ch);
+			void expect(char ch);
+			bool keyword(std::string_view word);
+
+			Json value();
+			Json object();
+			Json array();
+			Json number();
+			std::string string();
+			void append_utf8(std::string& out, unsigned code);
+			unsigned hex4();
+	};
+
+	Json JsonParser::document() {
+		auto result { value() };
+		skip_whitespace();
+		if (pos_ != text_.size()) { throw Error { "trailing characters after JSON value" }; }
+		return result;
+	}
+
+	void JsonParser::skip_whitespace() {
+		while (pos_ < text_.size() &&
+			(text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')
+		) {
+			++pos_;
+		}
+	}
+
+	bool JsonParser::consume(char ch) {
+		skip_whitespace();
+		if (pos_ < text_.size() && text_[pos_] == ch) { ++pos_; return true; }
+		return false;
+	}
+
+	void JsonParser::expect(char ch) {
+		if (!consume(ch)) { throw Error { std::string { "expected '" } + ch + "' in JSON" }; }
+	}
+
+	bool JsonParser::keyword(std::string_view word) {
+		if (text_.substr(pos_, word.size()) != word) { return false; }
+		pos_ += word.size();
+		return true;
+	}
+
+	Json JsonParser::value() {
+		skip_whitespace();
+		if (pos_ == text_.size()) { throw Error { "unexpected end of JSON" }; }
+		Json result;
+		switch (text_[pos_]) {
+			case '{': return object();
+			case '[': return array();
+			case '"':
+				result.kind = Json::Kind::string;
+				result.string = string();
+				return result;
+			default:
+				break;
+		}
+		if (keyword("true")) {
+			result.kind = Json::Kind::boolean;
+			result.boolean = true;
+			return result;
+		}
+		if (keyword("false")) {
+			result.kind = Json::Kind::boolean;
+			return result;
+		}
+		if (keyword("null")) { return result; }
+		return number();
+	}
+
+	Json JsonParser::object() {
+		Json result;
+		result.kind = Json::Kind::object;
+		expect('{');
+		if (consume('}')) { return result; }
+		do {
+			skip_whitespace();
+			if (pos_ == text_.size() || text_[pos_] != '"') {
+				throw Error { "expected member name in JSON" };
+			}
+			auto name { string() };
+			expect(':');
+			result.members.emplace_back(std::move(name), value());
+		} while (consume(','));
+		expect('}');
+		return result;
+	}
+
+	Json JsonParser::array() {
+		Json result;
+		result.kind = Json::Kind::array;
+		expect('[');
+		if (consume(']')) { return result; }
+		do {
+			result.items.push_back(value());
+		} while (consume(','));
+		expect(']');
+		return result;
+	}
+
+	Json JsonParser::number() {
+		auto start { pos_ };
+		while (pos_ < text_.size() && std::strchr("+-0123456789.eE", text_[pos_])) { ++pos_; }
+		if (start == pos_) { throw Error { "unexpected character in JSON" }; }
+		std::string digits { text_.substr(start, pos_ - start) };
+		char* end;
+		Json result;
+		result.kind = Json::Kind::number;
+		result.number = std::strtod(digits.c_str(), &end);
+		if (*end) { throw Error { "malformed number in JSON" }; }
+		return result;
+	}
+
+	std::string JsonParser::string() {
+		++pos_;
+		std::string result;
+		for (;;) {
+			if (pos_ == text_.size()) { throw Error { "unterminated string in JSON" }; }
+			char ch { text_[pos_++] };
+			if (ch == '"') { return result; }
+			if (ch != '\\') { result += ch; continue; }
+			if (pos_ == text_.size()) { throw Error { "unterminated string in JSON" }; }
+			switch (text_[pos_++]) {
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u': {
+					auto code { hex4() };
+					if (code >= 0xd800 && code < 0xdc00 && keyword("\\u")) {
+						code = 0x10000 + ((code - 0xd800) << 10) + (hex4() - 0xdc00);
+					}
+					append_utf8(result, code);
+					break;
+				}
+				default: throw Error { "unknown escape in JSON string" };
+			}
+		}
+	}
+
+	unsigned JsonParser::hex4() {
+		if (pos_ + 4 > text_.size()) { throw Error { "short \\u escape in JSON" }; }
+		unsigned code { 0 };
+		for (int i { 0 }; i < 4; ++i) {
+			char ch { text_[pos_++] };
+			code <<= 4;
+			if (ch >= '0' && ch <= '9') { code |= ch - '0'; }
+			else if (ch >= 'a' && ch <= 'f') { code |= ch - 'a' + 10; }
+			else if (ch >= 'A' && ch <= 'F') { code |= ch - 'A' + 10; }
+			else { throw Error { "bad \\u escape in JSON" }; }
+		}
+		return code;
+	}
+
+	void JsonParser::append_utf8(std::string& out, unsigned code) {
+		if (code < 0x80) {
+			out += static_cast<char>(code);
+		} else if (code < 0x800) {
+			out += static_cast<char>(0xc0 | (code >> 6));
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		} else if (code < 0x10000) {
+			out += static_cast<char>(0xe0 | (code >> 12));
+			out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		} else {
+			out += static_cast<char>(0xf0 | (code >> 18));
+			out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+			out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		}
+	}
+
+	std::string answer(const Json& request, const RequestHandler& handler, bool& stop) {
+		try {
+			return handler(request, stop);
+		}
+		catch (const std::exception& err) {
+			std::string out { "{" };
+			if (auto id { request.member("id") }) {
+				out += "\"id\":";
+				write_json(out, *id);
+				out += ",";
+			}
+			out += "\"error\":";
+			write_json_string(out, err.what());
+			return out + "}";
+		}
+	}
+
+	std::string answer_line(const std::string& line, const RequestHandler& handler, bool& stop) {
+		Json request;
+		try {
+			request = parse_json(line);
+		}
+		catch (const Error& err) {
+			std::string out { "{\"error\":" };
+			write_json_string(out, err.what());
+			return out + "}";
+		}
+		return answer(request, handler, stop);
+	}
+
+	// MSG_NOSIGNAL: a client that went away, or a connection shut down
+	// by the server, fails the write instead of raising SIGPIPE
+	bool write_all(int fd, std::string_view data) {
+		while (!data.empty()) {
+			auto written { ::send(fd, data.data(), data.size(), MSG_NOSIGNAL) };
+			if (written <= 0) { return false; }
+			data.remove_prefix(static_cast<std::size_t>(written));
+		}
+		return true;
+	}
+
+	void wake(const sockaddr_un& address) {
+		int fd { ::socket(AF_UNIX, SOCK_STREAM, 0) };
+		if (fd < 0) { return; }
+		::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+		::close(fd);
+	}
+
+	// removes a socket left at path, but no other kind of file
+	void remove_socket(const std::string& path) {
+		struct stat status;
+		if (::lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+			::unlink(path.c_str());
+		}
+	}
+
+	void serve_connection(int fd, const RequestHandler& handler, std::atomic<bool>& stopped) {
+		std::string pending;
+		char buffer[4096];
+		bool stop { false }, open { true };
+		while (open && !stop) {
+			auto got { ::read(fd, buffer, sizeof(buffer)) };
+			if (got <= 0) { break; }
+			pending.append(buffer, static_cast<std::size_t>(got));
+			std::size_t end;
+			while (open && !stop && (end = pending.find('\n')) != std::string::npos) {
+				auto line { pending.substr(0, end) };
+				pending.erase(0, end + 1);
+				if (line.find_first_not_of(" \t\r") == std::string::npos) { continue; }
+				// a client that went away ends its connection, not the server
+				open = write_all(fd, answer_line(line, handler, stop) + "\n");
+			}
+		}
+		if (stop) { stopped = true; }
+	}
+}
+
+const Json* Json::member(std::string_view name) const {
+	for (const auto& [key, value] : members) {
+		if (key == name) { return &value; }
+	}
+	return nullptr;
+}
+
+Json parse_json(std::string_view text) {
+	return JsonParser { text }.document();
+}
+
+void write_json_string(std::string& out, std::string_view text) {
+	static constexpr char digits[] { "0123456789abcdef" };
+	out += '"';
+	for (char ch : text) {
+		switch (ch) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(ch) < ' ') {
+					out += "\\u00";
+					out += digits[(ch >> 4) & 0xf];
+					out += digits[ch & 0xf];
+				} else {
+					out += ch;
+				}
+		}
+	}
+	out += '"';
+}
+
+void write_json(std::string& out, const Json& value) {
+	switch (value.kind) {
+		case Json::Kind::null: out += "null"; break;
+		case Json::Kind::boolean: out += value.boolean ? "true" : "false"; break;
+		case Json::Kind::number: {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%.17g", value.number);
+			out += buffer;
+			break;
+		}
+		case Json::Kind::string: write_json_string(out, value.string); break;
+		case Json::Kind::array: {
+			const char* separator { "" };
+			out += '[';
+			for (const auto& item : value.items) {
+				out += separator;
+				write_json(out, item);
+				separator = ",";
+			}
+			out += ']';
+			break;
+		}
+		case Json::Kind::object: {
+			const char* separator { "" };
+			out += '{';
+			for (const auto& [key, member] : value.members) {
+				out += separator;
+				write_json_string(out, key);
+				out += ':';
+				write_json(out, member);
+				separator = ",";
+			}
+			out += '}';
+			break;
+		}
+	}
+}
+
+void serve_stream(std::istream& in, std::ostream& out, const RequestHandler& handler) {
+	std::string line;
+	bool stop { false };
+	while (!stop && std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos) { continue; }
+		out << answer_line(line, handler, stop) << "\n";
+		out.flush();
+	}
+}
+
+void serve_socket(const std::string& path, const RequestHandler& handler) {
+	sockaddr_un address { };
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) { throw Error { "socket path too long: " + path }; }
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+	int listener { ::socket(AF_UNIX, SOCK_STREAM, 0) };
+	if (listener < 0) { throw Error { "can't create socket" }; }
+	remove_socket(path);
+	if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+		::listen(listener, 16) != 0
+	) {
+		::close(listener);
+		throw Error { "can't listen on " + path };
+	}
+
+	// After a shutdown request the server connects to itself to wake
+	// up accept(), then shuts down the connections still open so that
+	// clients waiting idle do not keep it alive. clients holds the open
+	// connections; each is closed under the mutex, so no descriptor is
+	// shut down after it was reused.
+	std::atomic<bool> stopped { false };
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::vector<int> clients;
+	while (!stopped) {
+		int fd { ::accept(listener, nullptr, nullptr) };
+		if (fd < 0) { break; }
+		if (stopped) { ::close(fd); break; }
+		{
+			std::lock_guard lock { mutex };
+			clients.push_back(fd);
+		}
+		std::thread { [&, fd] {
+			serve_connection(fd, handler, stopped);
+			if (stopped) { wake(address); }
+			std::lock_guard lock { mutex };
+			clients.erase(std::find(clients.begin(), clients.end(), fd));
+			::close(fd);
+			finished.notify_all();
+		} }.detach();
+	}
+	std::unique_lock lock { mutex };
+	for (int fd : clients) { ::shutdown(fd, SHUT_RDWR); }
+	finished.wait(lock, [&] { return clients.empty(); });
+	::close(listener);
+	remove_socket(path);
+}
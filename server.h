@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for the server protocol
+struct Json {
+	enum class Kind { null, boolean, number, string, array, object };
+
+	Kind kind { Kind::null };
+	bool boolean { false };
+	double number { 0 };
+	std::string string;
+	std::vector<Json> items;
+	std::vector<std::pair<std::string, Json>> members;
+
+	// nullptr if this is no object or has no such member
+	const Json* member(std::string_view name) const;
+};
+
+Json parse_json(std::string_view text);
+void write_json(std::string& out, const Json& value);
+void write_json_string(std::string& out, std::string_view text);
+
+// Answers one request line; setting stop ends the server after the
+// answer is sent.
+using RequestHandler = std::function<std::string(const Json& request, bool& stop)>;
+
+// Reads one JSON request per line and writes one JSON answer per line.
+// Malformed requests get an answer with an "error" member, and with
+// the "id" of the request if it could be parsed.
+void serve_stream(std::istream& in, std::ostream& out, const RequestHandler& handler);
+
+// Accepts connections on a Unix domain socket and serves each of them
+// like a stream in its own thread.
+void serve_socket(const std::string& path, const RequestHandler& handler);
@@ -0,0 +1,47 @@
+#include "source.h"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Source::Source(const std::string& path) {
+	int fd { ::open(path.c_str(), O_RDONLY) };
+	if (fd < 0) { throw std::runtime_error { "can't open " + path }; }
+
+	struct stat info { };
+	if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		void* mapped {
+			::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+		};
+		if (mapped != MAP_FAILED) {
+			::madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+			data_ = static_cast<const char*>(mapped);
+			size_ = info.st_size;
+			mapped_ = true;
+			::close(fd);
+			return;
+		}
+	}
+
+	// pipes, character devices or a failed mapping: read everything
+	char chunk[64 * 1024];
+	for (;;) {
+		auto got { ::read(fd, chunk, sizeof(chunk)) };
+		if (got < 0) {
+			::close(fd);
+			throw std::runtime_error { "can't read " + path };
+		}
+		if (got == 0) { break; }
+		buffer_.append(chunk, got);
+	}
+	::close(fd);
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+}
+
+Source::~Source() {
+	if (mapped_) { ::munmap(const_cast<char*>(data_), size_); }
+}
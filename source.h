@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+class Source {
+	private:
+		const char* data_ { nullptr };
+		std::size_t size_ { 0 };
+		bool mapped_ { false };
+		std::string buffer_;
+
+	public:
+		explicit Source(const std::string& path);
+		~Source();
+		Source(const Source&) = delete;
+		Source& operator=(const Source&) = delete;
+
+		const char* begin() const { return data_; }
+		const char* end() const { return data_ + size_; }
+		std::string_view text() const { return { data_, size_ }; }
+};
@@ -0,0 +1,435 @@
+#include "symbols.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "cache.h"
+#include "interface.h"
+
+namespace {
+	using Error = std::runtime_error;
+
+	constexpr std::string_view symbols_magic { "O2SM" };
+	constexpr std::uint8_t symbols_version { 1 };
+
+	class SymbolWriter {
+		private:
+			const Module& module_;
+			std::string& out_;
+
+		public:
+			SymbolWriter(const Module& module, std::string& out):
+				module_ { module }, out_ { out }
+			{ }
+
+			void module();
+
+			void byte(std::uint8_t value) { out_ += static_cast<char>(value); }
+			void number(std::uint64_t value);
+			void integer(std::int64_t value);
+			void fixed(std::uint64_t value);
+			void text(std::string_view value);
+
+		private:
+			bool is_local_type(const Name& name) const;
+			void value(const Value& value);
+			void type(const Type* type);
+			void signature(const Signature& signature);
+	};
+
+	class SymbolReader {
+		private:
+			std::string_view in_;
+			std::size_t pos_ { 0 };
+			ModuleInterface& interface_;
+
+		public:
+			SymbolReader(std::string_view in, ModuleInterface& interface):
+				in_ { in }, interface_ { interface }
+			{ }
+
+			void interface();
+
+		private:
+			void need(std::size_t count) const;
+			std::uint8_t byte();
+			std::uint64_t number();
+			std::int64_t integer();
+			std::uint64_t fixed();
+			std::string_view text();
+			Name name();
+
+			Value value();
+			Type* type();
+			Signature* signature();
+	};
+
+	void SymbolWriter::number(std::uint64_t value) {
+		while (value >= 0x80) {
+			byte(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		byte(static_cast<std::uint8_t>(value));
+	}
+
+	// zigzag, so small negative numbers stay short
+	void SymbolWriter::integer(std::int64_t value) {
+		number((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+	}
+
+	void SymbolWriter::fixed(std::uint64_t value) {
+		for (int i { 0 }; i < 8; ++i, value >>= 8) { byte(static_cast<std::uint8_t>(value)); }
+	}
+
+	void SymbolWriter::text(std::string_view value) {
+		number(value.size());
+		out_ += value;
+	}
+
+	bool SymbolWriter::is_local_type(const Name& name) const {
+		for (const auto* decl : module_.declarations.types) {
+			if (decl->ident.name == name) { return true; }
+		}
+		return false;
+	}
+
+	void SymbolWriter::module() {
+		const auto& declarations { module_.declarations };
+		text(module_.name.text());
+
+		std::vector<const ConstDecl*> consts;
+		for (const auto* decl : declarations.consts) {
+			if (!decl->ident.exported) { continue; }
+			if (decl->value->kind != ExprKind::constant) {
+				throw Error { "constant " + std::string { decl->ident.name.text() } + " is not constant" };
+			}
+			consts.push_back(decl);
+		}
+		number(consts.size());
+		for (const auto* decl : consts) {
+			text(decl->ident.name.text());
+			value(static_cast<const Constant*>(decl->value)->value);
+		}
+
+		std::vector<const TypeDecl*> types;
+		for (const auto* decl : declarations.types) {
+			if (decl->ident.exported) { types.push_back(decl); }
+		}
+		number(types.size());
+		for (const auto* decl : types) {
+			text(decl->ident.name.text());
+			type(decl->type);
+		}
+
+		std::vector<std::pair<const IdentDef*, const Type*>> vars;
+		for (const auto* decl : declarations.vars) {
+			for (const auto& ident : decl->names) {
+				if (ident.exported) { vars.emplace_back(&ident, decl->type); }
+			}
+		}
+		number(vars.size());
+		for (const auto& [ident, var_type] : vars) {
+			text(ident->name.text());
+			type(var_type);
+		}
+
+		std::vector<const ProcDecl*> procedures;
+		for (const auto* procedure : declarations.procedures) {
+			if (procedure->ident.exported) { procedures.push_back(procedure); }
+		}
+		number(procedures.size());
+		for (const auto* procedure : procedures) {
+			text(procedure->ident.name.text());
+			signature(*procedure->signature);
+		}
+	}
+
+	void SymbolWriter::value(const Value& value) {
+		byte(static_cast<std::uint8_t>(value.kind));
+		switch (value.kind) {
+			case ValueKind::real: {
+				std::uint64_t bits;
+				std::memcpy(&bits, &value.real, sizeof(bits));
+				fixed(bits);
+				break;
+			}
+			case ValueKind::string:
+				text(value.string);
+				break;
+			default:
+				integer(value.integer);
+		}
+	}
+
+	// Type names are qualified by the full name of their module, only
+	// predeclared types stay unqualified.
+	void SymbolWriter::type(const Type* type) {
+		if (!type) { byte(0); return; }
+		byte(static_cast<std::uint8_t>(type->kind) + 1);
+		switch (type->kind) {
+			case TypeKind::named: {
+				const auto& ident { static_cast<const NamedType*>(type)->ident };
+				if (!ident.module.empty()) {
+					auto full_name { ident.module };
+					for (const auto& import : module_.imports) {
+						if (import.alias == ident.module) { full_name = import.module; break; }
+					}
+					text(full_name.text());
+				} else {
+					text(is_local_type(ident.name) ? module_.name.text() : std::string_view { });
+				}
+				text(ident.name.text());
+				break;
+			}
+			case TypeKind::array: {
+				const auto& array { *static_cast<const ArrayType*>(type) };
+				number(array.lengths.size());
+				for (const auto* length : array.lengths) {
+					if (length->kind != ExprKind::constant) {
+						throw Error { "array length is not constant" };
+					}
+					integer(static_cast<const Constant*>(length)->value.integer);
+				}
+				this->type(array.element);
+				break;
+			}
+			case TypeKind::open_array:
+				this->type(static_cast<const OpenArrayType*>(type)->element);
+				break;
+			case TypeKind::record: {
+				const auto& record { *static_cast<const RecordType*>(type) };
+				this->type(record.base);
+				number(record.fields.size());
+				for (const auto& fields : record.fields) {
+					number(fields.names.size());
+					for (const auto& ident : fields.names) {
+						text(ident.name.text());
+						byte(ident.exported);
+					}
+					this->type(fields.type);
+				}
+				break;
+			}
+			case TypeKind::pointer:
+				this->type(static_cast<const PointerType*>(type)->target);
+				break;
+			case TypeKind::procedure:
+				signature(*static_cast<const ProcedureType*>(type)->signature);
+				break;
+		}
+	}
+
+	void SymbolWriter::signature(const Signature& signature) {
+		number(signature.sections.size());
+		for (const auto& section : signature.sections) {
+			byte(section.reference);
+			number(section.names.size());
+			for (const auto& ident : section.names) { text(ident.name.text()); }
+			type(section.type);
+		}
+		type(signature.result);
+	}
+
+	void SymbolReader::need(std::size_t count) const {
+		if (in_.size() - pos_ < count) { throw Error { "truncated symbol file" }; }
+	}
+
+	std::uint8_t SymbolReader::byte() {
+		need(1);
+		return static_cast<std::uint8_t>(in_[pos_++]);
+	}
+
+	std::uint64_t SymbolReader::number() {
+		std::uint64_t result { 0 };
+		for (int shift { 0 }; shift < 64; shift += 7) {
+			auto next { byte() };
+			result |= static_cast<std::uint64_t>(next & 0x7f) << shift;
+			if (!(next & 0x80)) { return result; }
+		}
+		throw Error { "malformed number in symbol file" };
+	}
+
+	std::int64_t SymbolReader::integer() {
+		auto value { number() };
+		return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+	}
+
+	std::uint64_t SymbolReader::fixed() {
+		std::uint64_t result { 0 };
+		for (int i { 0 }; i < 8; ++i) {
+			result |= static_cast<std::uint64_t>(byte()) << (8 * i);
+		}
+		return result;
+	}
+
+	// the text is copied, the symbol file is unmapped after reading
+	std::string_view SymbolReader::text() {
+		auto size { number() };
+		need(size);
+		auto result { interface_.arena.copy(in_.substr(pos_, size)) };
+		pos_ += size;
+		return result;
+	}
+
+	Name SymbolReader::name() {
+		auto value { text() };
+		return value.empty() ? Name { } : interface_.names.intern(value);
+	}
+
+	void SymbolReader::interface() {
+		if (in_.substr(0, symbols_magic.size()) != symbols_magic) {
+			throw Error { "no symbol file" };
+		}
+		pos_ = symbols_magic.size();
+		if (byte() != symbols_version) { throw Error { "unknown symbol file version" }; }
+		interface_.fingerprint = fixed();
+		interface_.source_hash = fixed();
+		auto dependencies { number() };
+		for (std::uint64_t i { 0 }; i < dependencies; ++i) {
+			std::string name { text() };
+			interface_.dependencies.emplace_back(std::move(name), fixed());
+		}
+		if (Hash { }.add(in_.substr(pos_)).value() != interface_.fingerprint) {
+			throw Error { "corrupt symbol file" };
+		}
+
+		interface_.name = text();
+		for (auto count { number() }; count; --count) {
+			std::string name { text() };
+			interface_.consts.emplace(std::move(name), value());
+		}
+		for (auto count { number() }; count; --count) {
+			std::string name { text() };
+			interface_.types.emplace(std::move(name), type());
+		}
+		for (auto count { number() }; count; --count) {
+			std::string name { text() };
+			interface_.vars.emplace(std::move(name), type());
+		}
+		for (auto count { number() }; count; --count) {
+			std::string name { text() };
+			interface_.procedures.emplace(std::move(name), signature());
+		}
+		if (pos_ != in_.size()) { throw Error { "trailing bytes in symbol file" }; }
+	}
+
+	Value SymbolReader::value() {
+		Value result;
+		auto kind { byte() };
+		if (kind > static_cast<std::uint8_t>(ValueKind::set)) {
+			throw Error { "unknown constant in symbol file" };
+		}
+		result.kind = static_cast<ValueKind>(kind);
+		switch (result.kind) {
+			case ValueKind::real: {
+				auto bits { fixed() };
+				std::memcpy(&result.real, &bits, sizeof(bits));
+				break;
+			}
+			case ValueKind::string:
+				result.string = text();
+				break;
+			default:
+				result.integer = integer();
+		}
+		return result;
+	}
+
+	Type* SymbolReader::type() {
+		auto tag { byte() };
+		if (!tag) { return nullptr; }
+		if (tag > static_cast<std::uint8_t>(TypeKind::procedure) + 1) {
+			throw Error { "unknown type in symbol file" };
+		}
+		auto& arena { interface_.arena };
+		Type header { static_cast<TypeKind>(tag - 1), 0 };
+		switch (header.kind) {
+			case TypeKind::named: {
+				auto module { name() };
+				return arena.make<NamedType>(header, QualIdent { module, name() });
+			}
+			case TypeKind::array: {
+				std::vector<Expr*> lengths;
+				for (auto count { number() }; count; --count) {
+					Value length;
+					length.integer = integer();
+					lengths.push_back(arena.make<Constant>(Expr { ExprKind::constant, 0 }, length));
+				}
+				auto span { make_span(arena, lengths) };
+				return arena.make<ArrayType>(header, span, type());
+			}
+			case TypeKind::open_array:
+				return arena.make<OpenArrayType>(header, type());
+			case TypeKind::record: {
+				auto record { arena.make<RecordType>(header) };
+				record->base = type();
+				std::vector<FieldList> fields;
+				for (auto count { number() }; count; --count) {
+					std::vector<IdentDef> names;
+					for (auto name_count { number() }; name_count; --name_count) {
+						auto field { name() };
+						names.push_back({ field, byte() != 0, 0 });
+					}
+					auto span { make_span(arena, names) };
+					fields.push_back({ span, type() });
+				}
+				record->fields = make_span(arena, fields);
+				return record;
+			}
+			case TypeKind::pointer:
+				return arena.make<PointerType>(header, type());
+			case TypeKind::procedure:
+				return arena.make<ProcedureType>(header, signature());
+		}
+		return nullptr;
+	}
+
+	Signature* SymbolReader::signature() {
+		auto result { interface_.arena.make<Signature>() };
+		std::vector<ParameterSection> sections;
+		for (auto count { number() }; count; --count) {
+			ParameterSection section { };
+			section.reference = byte() != 0;
+			std::vector<IdentDef> names;
+			for (auto name_count { number() }; name_count; --name_count) {
+				names.push_back({ name(), false, 0 });
+			}
+			section.names = make_span(interface_.arena, names);
+			section.type = type();
+			sections.push_back(section);
+		}
+		result->sections = make_span(interface_.arena, sections);
+		result->result = type();
+		return result;
+	}
+}
+
+std::string write_symbols(
+	const Module& module, std::uint64_t source_hash,
+	const std::vector<const ModuleInterface*>& imports
+) {
+	std::string body;
+	SymbolWriter { module, body }.module();
+
+	std::string result;
+	SymbolWriter header { module, result };
+	result += symbols_magic;
+	header.byte(symbols_version);
+	header.fixed(Hash { }.add(body).value());
+	header.fixed(source_hash);
+	std::size_t known { 0 };
+	for (const auto* import : imports) { known += import != nullptr; }
+	header.number(known);
+	for (const auto* import : imports) {
+		if (!import) { continue; }
+		header.text(import->name);
+		header.fixed(import->fingerprint);
+	}
+	return result + body;
+}
+
+std::shared_ptr<ModuleInterface> read_symbols(std::string_view bytes) {
+	auto interface { std::make_shared<ModuleInterface>() };
+	SymbolReader { bytes, *interface }.interface();
+	return interface;
+}
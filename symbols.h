@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+
+struct ModuleInterface;
+
+// Symbol files (.smb) hold the exported constants, types, variables and
+// procedure signatures of a module in a compact binary form. They start
+// with a fingerprint over the exported declarations, the hash of the
+// module source and the fingerprints of the imported interfaces that
+// were used to fold the constants.
+
+// imports holds the interfaces of module.imports, nullptr where unknown
+std::string write_symbols(
+	const Module& module, std::uint64_t source_hash,
+	const std::vector<const ModuleInterface*>& imports
+);
+
+// throws if bytes is no valid symbol file
+std::shared_ptr<ModuleInterface> read_symbols(std::string_view bytes);